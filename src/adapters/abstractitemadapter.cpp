@@ -21,7 +21,6 @@
 #include <atomic>
 
 // Qt
-#include <QtCore/QTimer>
 #include <QQmlContext>
 #include <QQuickItem>
 #include <QQmlEngine>
@@ -38,6 +37,8 @@
 #include "modeladapter.h"
 #include "private/statetracker/index_p.h"
 #include "viewbase.h"
+#include "private/viewbase_p.h"
+#include "private/framescheduler_p.h"
 #include "contextadapterfactory.h"
 #include "contextadapter.h"
 
@@ -49,6 +50,7 @@ public:
 
     // Helpers
     inline void load();
+    void releaseItem();
 
     // Actions
     bool attach ();
@@ -121,6 +123,8 @@ AbstractItemAdapter::AbstractItemAdapter(Viewport* r) :
 
 AbstractItemAdapter::~AbstractItemAdapter()
 {
+    s_ptr->m_pViewport->s_ptr->notifyUnloaded(s_ptr);
+
     if (d_ptr->m_pItem)
         delete d_ptr->m_pItem;
 
@@ -188,6 +192,13 @@ QQuickItem* StateTracker::ViewItem::item() const
 
 bool AbstractItemAdapterPrivate::attach()
 {
+    if ((!m_pItem) && q_ptr->s_ptr->m_pViewport->s_ptr->deferLoading(q_ptr->s_ptr)) {
+        q_ptr->s_ptr->m_IsEvicted = true;
+        return true;
+    }
+
+    q_ptr->s_ptr->m_IsEvicted = false;
+
     if (m_pItem)
         m_pItem->setVisible(true);
 
@@ -196,11 +207,37 @@ bool AbstractItemAdapterPrivate::attach()
 
 bool AbstractItemAdapterPrivate::refresh()
 {
+    // The delegate creation was deferred to the FrameScheduler
+    if ((!m_pItem) && q_ptr->s_ptr->m_IsEvicted) {
+        q_ptr->s_ptr->m_IsEvicted = false;
+        return q_ptr->attach();
+    }
+
     return q_ptr->refresh();
 }
 
 bool AbstractItemAdapterPrivate::move()
 {
+    if ((!m_pItem) && q_ptr->s_ptr->m_pViewport->s_ptr->deferLoading(q_ptr->s_ptr)) {
+        q_ptr->s_ptr->m_IsEvicted = true;
+        return true;
+    }
+
+    // The QQuickItem is new, the view has to connect to it again. Its own
+    // `attach()` loads and places it.
+    if ((!m_pItem) && q_ptr->s_ptr->m_IsEvicted) {
+        q_ptr->s_ptr->m_IsEvicted = false;
+
+        // It is loaded now, the deferred creation would only refresh it
+        const auto md = q_ptr->s_ptr->m_pMetadata;
+        if (md && md->scheduler())
+            md->scheduler()->cancel(md);
+
+        return q_ptr->attach();
+    }
+
+    q_ptr->s_ptr->m_pViewport->s_ptr->touch(q_ptr->s_ptr);
+
     const bool ret = q_ptr->move();
 
     // Views should apply the geometry they have been told to apply. Otherwise
@@ -219,7 +256,10 @@ bool AbstractItemAdapterPrivate::remove()
 {
     bool ret = q_ptr->remove();
 
-    m_pItem->setParentItem(nullptr);
+    // Evicted delegates have no QQuickItem
+    if (m_pItem)
+        m_pItem->setParentItem(nullptr);
+
     q_ptr->s_ptr->m_pMetadata = nullptr;
 
     return ret;
@@ -227,9 +267,9 @@ bool AbstractItemAdapterPrivate::remove()
 
 bool AbstractItemAdapterPrivate::hide()
 {
-    Q_ASSERT(m_pItem);
+    // It was evicted, there is nothing to hide
     if (!m_pItem)
-        return false;
+        return true;
 
     m_pItem->setVisible(false);
 
@@ -239,7 +279,9 @@ bool AbstractItemAdapterPrivate::hide()
 // This methodwrap the removal of the element from the view
 bool AbstractItemAdapterPrivate::detach()
 {
-    m_pItem->setParentItem(nullptr);
+    if (m_pItem)
+        m_pItem->setParentItem(nullptr);
+
     remove();
 
     //FIXME
@@ -263,24 +305,33 @@ bool AbstractItemAdapterPrivate::error()
 }
 #pragma GCC diagnostic pop
 
-bool AbstractItemAdapterPrivate::destroy()
+void AbstractItemAdapterPrivate::releaseItem()
 {
-    auto ptrCopy = m_pLocker;
+    q_ptr->s_ptr->m_pViewport->s_ptr->notifyUnloaded(q_ptr->s_ptr);
+
+    if (!m_pItem)
+        return;
+
+    disconnect(m_pItem, &QObject::destroyed, this, &AbstractItemAdapterPrivate::slotDestroyed);
+    m_pItem->setVisible(false);
+    m_pItem->setParentItem(nullptr);
+    q_ptr->view()->s_ptr->bury(m_pItem);
 
-    //FIXME manage to add to the pool without a SEGFAULT
-    if (m_pItem) {
-        m_pItem->setParentItem(nullptr);
-        delete m_pItem;
-    }
     m_pItem = nullptr;
+}
 
-    QTimer::singleShot(0,[this, ptrCopy]() {
-        if (!ptrCopy)
-            delete this;
-        // else the reference will be dropped and the destructor called
-    });
+bool AbstractItemAdapterPrivate::destroy()
+{
+    auto graveyard = q_ptr->view()->s_ptr;
+
+    //FIXME manage to add to the pool without a SEGFAULT
+    releaseItem();
 
-    if (m_pLocker)
+    // When there is a locker, the reference will be dropped and the
+    // destructor called
+    if (!m_pLocker)
+        graveyard->bury(this);
+    else
         m_pLocker.clear();
 
     return true;
@@ -296,6 +347,15 @@ bool StateTracker::ViewItem::performAction(IndexMetadata::ViewAction a)
     return (d_ptr->d_ptr ->* d_ptr->d_ptr->m_fStateMachine[s][(int)a])();
 }
 
+void StateTracker::ViewItem::evict()
+{
+    d_ptr->d_ptr->releaseItem();
+    m_IsEvicted = true;
+
+    // The context belongs to the IndexMetadata, `load()` will fetch it again
+    d_ptr->d_ptr->m_pContext = nullptr;
+}
+
 int StateTracker::ViewItem::depth() const
 {
     return m_pMetadata->indexTracker()->depth();
@@ -366,6 +426,15 @@ void AbstractItemAdapterPrivate::load()
     }
 
     Q_ASSERT(q_ptr->s_ptr->m_pMetadata->geometryTracker()->state() != StateTracker::Geometry::State::INIT);
+
+    // Keep the number of live delegates within the budget
+    q_ptr->s_ptr->m_pViewport->s_ptr->notifyLoaded(q_ptr->s_ptr);
+
+    // Loaded again by another action than a move, like a role update
+    if (q_ptr->s_ptr->m_IsEvicted) {
+        q_ptr->s_ptr->m_IsEvicted = false;
+        q_ptr->attach();
+    }
 }
 
 QQmlContext *AbstractItemAdapter::context() const
@@ -436,47 +505,25 @@ void AbstractItemAdapter::setSelected(bool /*s*/)
 
 QPair<QQuickItem*, QQmlContext*> AbstractItemAdapterPrivate::loadDelegate(QQuickItem* parentI) const
 {
-    const auto delegate = q_ptr->s_ptr->m_pViewport->modelAdapter()->delegate();
-    if (!delegate) {
-        qWarning() << "No delegate is set";
-        return {};
-    }
-
-    auto pctx = q_ptr->s_ptr->m_pMetadata->contextAdapter()->context();
-
-    // Create a parent item to hold the delegate and all children
-    auto container = qobject_cast<QQuickItem *>(q_ptr->s_ptr->m_pViewport->s_ptr->component()->create(pctx));
-    container->setWidth(q_ptr->view()->width());
-    q_ptr->s_ptr->m_pViewport->s_ptr->engine()->setObjectOwnership(container, QQmlEngine::CppOwnership);
-    container->setParentItem(parentI);
+    auto md   = q_ptr->s_ptr->m_pMetadata;
 
-    // Create a context with all the tree roles
-    auto ctx = new QQmlContext(pctx);
+    // It was created ahead of time, when the application was idle. This has
+    // to be done before `contextAdapter()` creates a new one.
+    auto warm = md->takeWarmDelegate();
+    auto pctx = md->contextAdapter()->context();
 
-    // Create the delegate
-    auto item = qobject_cast<QQuickItem *>(delegate->create(ctx));
-    q_ptr->s_ptr->m_pViewport->s_ptr->engine()->setObjectOwnership(item, QQmlEngine::CppOwnership);
+    if (warm) {
+        warm->setWidth(q_ptr->view()->width());
+        warm->setParentItem(parentI);
+        warm->setVisible(true);
 
-    // It allows the children to be added anyway
-    if(!item) {
-        if (!delegate->errorString().isEmpty())
-            qWarning() << delegate->errorString();
-
-        return {container, pctx};
+        return {warm, pctx};
     }
 
-    item->setWidth(q_ptr->view()->width());
-    item->setParentItem(container);
-
-    // Resize the container
-    container->setHeight(item->height());
-
-    // Make sure it can be resized dynamically
-    QObject::connect(item, &QQuickItem::heightChanged, container, [container, item](){
-        container->setHeight(item->height());
-    });
+    auto container = q_ptr->s_ptr->m_pViewport->s_ptr->createDelegate(pctx);
 
-    container->setProperty("content", QVariant::fromValue(item));
+    if (container)
+        container->setParentItem(parentI);
 
     return {container, pctx};
 }
@@ -632,6 +679,7 @@ StateTracker::ViewItem::State StateTracker::ViewItem::state() const
 void AbstractItemAdapterPrivate::slotDestroyed()
 {
     m_pItem = nullptr;
+    q_ptr->s_ptr->m_pViewport->s_ptr->notifyUnloaded(q_ptr->s_ptr);
 }
 
 #include <abstractitemadapter.moc>
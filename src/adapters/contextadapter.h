@@ -24,6 +24,7 @@ class QQmlContext;
 // KQuickItemViews
 class AbstractItemAdapter;
 class ContextAdapterFactory;
+class ContextAdapterFactoryPrivate;
 class DynamicContext;
 class ContextExtension;
 
@@ -40,11 +41,15 @@ class ContextExtension;
  *
  * These objects MUST BE CREATED AFTER the last call to addContextExtension
  * has been made and the model(index) has been set.
+ *
+ * The QObject exposed to QML and its QQmlContext are only created the first
+ * time `context()` or `contextObject()` is called (for performance).
  */
 class ContextAdapter
 {
     friend class AbstractItemAdapter;
     friend class ContextAdapterFactory; //factory
+    friend class DynamicContext; // m_Index and m_Cache
 public:
     virtual ~ContextAdapter();
 
@@ -54,7 +59,16 @@ public:
     bool isActive() const;
 
     virtual QModelIndex index() const;
-    void setModelIndex(const QModelIndex& index);
+
+    /**
+     * Bind the context to another index.
+     *
+     * The values of the properties in use are fetched at once and only the
+     * changed ones are notified. When `notify` is false, the cache is dropped
+     * and nothing is notified. Call `invalidate()` once the bindings need to
+     * be evaluated again (for example when a detached delegate is reused).
+     */
+    void setModelIndex(const QModelIndex& index, bool notify = true);
 
     virtual QQmlContext* context() const final;
     virtual AbstractItemAdapter* item() const;
@@ -63,7 +77,7 @@ public:
      * Clear the cache entry and send the notify signal on the property `id`
      * from the extension `e`.
      */
-    void dismissCache(ContextExtension* e, int id);
+    void dismissCache(const ContextExtension* e, int id);
 
     /**
      * Notify the adapter some QModelIndex roles changed.
@@ -72,6 +86,16 @@ public:
      */
     bool updateRoles(const QVector<int> &modified) const;
 
+    /**
+     * Notify the adapter the model structure around its index changed.
+     *
+     * Only the extension properties declared with matching
+     * ContextExtension::structuralDependencies are refreshed.
+     *
+     * @return True when the properties changed, false otherwise.
+     */
+    bool updateStructure(int flags) const;
+
     /**
      * Clear the cache of role values.
      *
@@ -82,13 +106,30 @@ public:
      */
     void flushCache();
 
+    /**
+     * Clear the cache and notify all properties, including the ones added by
+     * the extensions.
+     *
+     * Use this when the adapter starts to represent another QModelIndex
+     * behind the back of `setModelIndex`, like when a pre-created delegate
+     * is handed to an index.
+     */
+    void invalidate();
+
     QObject *contextObject() const;
 
 protected:
     explicit ContextAdapter(QQmlContext *parentContext = nullptr);
 
 private:
-    DynamicContext* d_ptr {nullptr};
+    /// Create the QObject on first use
+    DynamicContext* dynamicContext() const;
+
+    mutable DynamicContext       *d_ptr       {nullptr};
+    ContextAdapterFactoryPrivate *m_pFactory  {nullptr};
+    QQmlContext                  *m_pParentCtx{nullptr};
+    QPersistentModelIndex         m_Index     {       };
+    bool                          m_Cache     { true  };
 };
 
 Q_DECLARE_METATYPE(ContextAdapter*)
@@ -61,6 +61,7 @@ public:
     int  m_MaxDepth    { -1  };
     int  m_CacheBuffer { 10  };
     int  m_PoolSize    { 10  };
+    int  m_MaxLive     {  0  };
 
     int m_ExpandedCount { 999 }; //TODO
 
@@ -270,6 +271,46 @@ void ModelAdapter::setRecyclingMode(ModelAdapter::RecyclingMode mode)
     d_ptr->m_RecyclingMode = mode;
 }
 
+int ModelAdapter::maxLiveDelegates() const
+{
+    return d_ptr->m_MaxLive;
+}
+
+void ModelAdapter::setMaxLiveDelegates(int value)
+{
+    d_ptr->m_MaxLive = std::max(0, value);
+
+    for (auto vp : viewports())
+        vp->s_ptr->enforceDelegateBudget();
+}
+
+int ModelAdapter::liveDelegates() const
+{
+    int ret = 0;
+
+    for (auto vp : viewports())
+        ret += vp->s_ptr->m_LiveCount;
+
+    return ret;
+}
+
+QStringList ModelAdapter::usedRoles() const
+{
+    QStringList ret;
+
+    if (!d_ptr->m_pRoleContextFactory)
+        return ret;
+
+    const auto roles = d_ptr->m_pRoleContextFactory->usedRoles();
+
+    for (const auto& r : roles)
+        ret << QString::fromLatin1(r);
+
+    ret.sort();
+
+    return ret;
+}
+
 void ModelAdapter::setSelectionAdapter(SelectionAdapter* v)
 {
     d_ptr->m_pSelectionManager = v;
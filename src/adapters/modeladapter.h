@@ -18,6 +18,7 @@
 #pragma once
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 
 // KQuickItemViews
 class SelectionAdapter;
@@ -59,8 +60,14 @@ public:
     Q_PROPERTY(RecyclingMode recyclingMode READ recyclingMode WRITE setRecyclingMode)
     /// The number of elements to be preloaded outside of the visible area (for latency)
     Q_PROPERTY(int cacheBuffer READ cacheBuffer WRITE setCacheBuffer)
-    /// The number of delegates to be kept in a recycling pool (for performance)
+    /// The number of delegates to be kept in a recycling pool, they are pre-created when idle (for latency)
     Q_PROPERTY(int poolSize READ poolSize WRITE setPoolSize)
+    /// The maximum number of live delegates, the least recently visible are freed first, 0 for no limit (for performance)
+    Q_PROPERTY(int maxLiveDelegates READ maxLiveDelegates WRITE setMaxLiveDelegates)
+    /// The number of delegates currently instantiated
+    Q_PROPERTY(int liveDelegates READ liveDelegates NOTIFY liveDelegatesChanged)
+    /// The roles read by the delegates, the others are never fetched or updated (for performance)
+    Q_PROPERTY(QStringList usedRoles READ usedRoles)
 
     enum RecyclingMode {
         NoRecycling    , /*!< Destroy and create new QQuickItems all the time         */
@@ -96,6 +103,13 @@ public:
     RecyclingMode recyclingMode() const;
     void setRecyclingMode(RecyclingMode mode);
 
+    int maxLiveDelegates() const;
+    void setMaxLiveDelegates(int value);
+
+    int liveDelegates() const;
+
+    QStringList usedRoles() const;
+
     bool isEmpty() const;
 
     bool isCollapsed() const;
@@ -120,6 +134,7 @@ Q_SIGNALS:
     void delegateChanged(QQmlComponent* delegate);
     void contentChanged();
     void collapsedChanged();
+    void liveDelegatesChanged();
 
 private:
     ModelAdapterPrivate *d_ptr;
@@ -19,12 +19,17 @@
 
 // Qt
 #include <QtCore/QAbstractItemModel>
-#include <QtCore/QMutex>
+#include <QtCore/QVarLengthArray>
 #include <QtCore/private/qmetaobjectbuilder_p.h>
 #include <QQmlContext>
 #include <QQuickItem>
 #include <QQmlEngine>
 
+// LibStdC++
+#include <algorithm>
+#include <cstring>
+#include <new>
+
 // KQuickItemViews
 #include "adapters/abstractitemadapter.h"
 #include "viewbase.h"
@@ -32,6 +37,7 @@
 #include "private/viewport_p.h"
 #include "private/indexmetadata_p.h"
 #include "extensions/contextextension.h"
+#include "extensions/multirolemodel.h"
 #include "adapters/modeladapter.h"
 #include "private/statetracker/viewitem_p.h"
 #include "adapters/contextadapter.h"
@@ -73,6 +79,27 @@ struct MetaProperty
     QByteArray* name {nullptr};
 
     uint signalId;
+
+    /// The QMetaType::Type exposed to QML
+    int type {QMetaType::QVariant};
+};
+
+/**
+ * The cached value of a property.
+ *
+ * The most common role types are stored unboxed. The active member is
+ * defined by MetaProperty::type.
+ */
+union ValueSlot
+{
+    ValueSlot() {}
+    ~ValueSlot() {}
+
+    int      i;
+    double   d;
+    bool     b;
+    QString  s;
+    QVariant v;
 };
 
 struct GroupMetaData
@@ -97,34 +124,33 @@ public:
  * generator.
  *
  * It holds a "fake" type of QObject designed to reflect the model roles as
- * QObject properties. It also tracks the property being *used* by QML to
- * prevent too many events being pushed into the QML context.
+ * QObject properties.
+ *
+ * It only depends on the role names and on the extension property names, so
+ * it is shared by all factories with the same ones. Anything specific to a
+ * factory (the extension instances and the used roles) lives in
+ * ContextAdapterFactoryPrivate.
  */
 struct DynamicMetaType final
 {
     explicit DynamicMetaType(const QHash<int, QByteArray>& roles);
-    ~DynamicMetaType() {
-        delete[] roles;//FIXME leak [roleCount*sizeof(MetaProperty))];
-    }
+    ~DynamicMetaType();
+
+    /// Get (or create) the shared metatype for a factory
+    static DynamicMetaType* acquire(ContextAdapterFactoryPrivate* d, const QHash<int, QByteArray>& roles);
+
+    /// Delete the metatype when the last factory or context stops using it
+    void release();
 
     const size_t              roleCount     {   0   };
     size_t                    propertyCount {   0   };
     MetaProperty*             roles         {nullptr};
-    QSet<MetaProperty*>       used          {       };
     QMetaObject              *m_pMetaObject {nullptr};
     bool                      m_GroupInit   { false };
     QHash<int, MetaProperty*> m_hRoleIds    {       };
     uint8_t                  *m_pCacheMap   {nullptr};
-
-    /**
-     * Assuming the number of role is never *that* high, keep a jump map to
-     * prevent doing dispatch vTable when checking the properties source.
-     *
-     * In theory it can be changed at runtime if the need arise, but for now
-     * its static. Better harden the binaries a bit, having call maps on the
-     * heap isn't the most secure scheme in the universe.
-     */
-    GroupMetaData* m_lGroupMapping {nullptr};
+    int                       m_RefCount    {   0   };
+    QByteArray                m_Key         {       };
 };
 
 class DynamicContext final : public QObject
@@ -138,15 +164,81 @@ public:
     virtual void* qt_metacast(const char *name) override;
     virtual const QMetaObject *metaObject() const override;
 
-    // Use a C array to prevent the array bound checks
-    QVariant              **m_lVariants {nullptr};
+    /*
+     * Use C arrays to prevent the array bound checks. Both the values and
+     * the validity bitmap are allocated in a single block when the context
+     * is created. Reading a cached value then only copies an implicitly
+     * shared QVariant.
+     */
+    ValueSlot             * m_lValues   {nullptr};
+    quint32               * m_lValid    {nullptr};
     DynamicMetaType       * m_pMetaType {nullptr};
-    bool                    m_Cache     { true  };
     QQmlContext           * m_pCtx      {nullptr};
-    QPersistentModelIndex   m_Index     {       };
-    QQmlContext           * m_pParentCtx{nullptr};
     QMetaObject::Connection m_Conn;
-    QMutex                  m_Mutex;
+
+    // Cache helpers
+    inline bool supportsCache(uint id) const {
+        return m_pBuilder->m_Cache && (m_pMetaType->m_pCacheMap[id/8] & (1 << (id % 8)));
+    }
+
+    inline bool isCached(uint id) const {
+        return m_lValid[id/32] & (1u << (id%32));
+    }
+
+    inline void setCached(uint id) {
+        m_lValid[id/32] |= 1u << (id%32);
+    }
+
+    inline void dismiss(uint id) {
+        m_lValid[id/32] &= ~(1u << (id%32));
+
+        // Release the memory right away
+        switch(m_pMetaType->roles[id].type) {
+            case QMetaType::QString:
+                m_lValues[id].s = QString();
+                break;
+            case QMetaType::QVariant:
+                m_lValues[id].v = QVariant();
+                break;
+        }
+    }
+
+    /// Convert and store the value in the slot
+    void store(uint id, const QVariant& v);
+
+    /// Copy the slot into a moc style return value
+    void load(uint id, void *out) const;
+
+    /// Compare the slot with a fetched value
+    bool equals(uint id, const QVariant& v) const;
+
+    /// Get the current value from the extension (or model)
+    QVariant fetch(uint id) const;
+
+    /**
+     * Notify the property when its value changed.
+     *
+     * @return If the change signal was emitted
+     */
+    bool refresh(MetaProperty *mr);
+
+    /**
+     * Fill the cache for all the used properties at once.
+     *
+     * @return If there was anything to fetch
+     */
+    bool prefetch();
+
+    /**
+     * The index changed, compare all the cached values with the new ones and
+     * notify the changed properties.
+     */
+    void rebind();
+
+    /// Fetch the sorted `ids` with a single call per extension
+    void fetchMany(const QVarLengthArray<uint, 32>& ids, QVector<QVariant>& values) const;
+
+    QModelIndex currentIndex() const;
 
     ContextAdapterFactoryPrivate* d_ptr {nullptr};
     ContextAdapter* m_pBuilder;
@@ -159,13 +251,59 @@ public:
     QList<ContextExtension*>  m_lGroups   {       };
     mutable DynamicMetaType  *m_pMetaType {nullptr};
     QAbstractItemModel       *m_pModel    {nullptr};
+    MultiRoleModel           *m_pMulti    {nullptr};
+    QSet<MetaProperty*>       m_lUsed     {       };
+    QHash<QByteArray, int>    m_hRoleTypes{       };
+
+    /// The type of each role (by role id) once resolved
+    QHash<int, int> m_hTypes;
+
+    /// The extension properties (by propId) computed from each role
+    QHash<int, QVector<uint>> m_hDependents;
+    QVector<uint>             m_lComputed;
+
+    /// The extension properties (by propId) computed from the structure
+    QVector<uint> m_lRowDependents;
+    QVector<uint> m_lChildrenDependents;
+
+    /// Bitmap of the properties read by QML, indexed by propId
+    quint32 *m_lRead {nullptr};
+
+    /**
+     * Assuming the number of role is never *that* high, keep a jump map to
+     * prevent doing dispatch vTable when checking the properties source.
+     *
+     * In theory it can be changed at runtime if the need arise, but for now
+     * its static. Better harden the binaries a bit, having call maps on the
+     * heap isn't the most secure scheme in the universe.
+     */
+    GroupMetaData* m_lGroupMapping {nullptr};
 
     FactoryFunctor m_fFactory;
 
     // Helper
     void initGroup(const QHash<int, QByteArray>& rls);
+    void initMapping();
+    void initDependencies();
+    void inferTypes(const QHash<int, QByteArray>& rls);
+    QByteArray key(const QHash<int, QByteArray>& rls) const;
     void finish();
 
+    inline bool isRead(uint id) const {
+        return m_lRead[id/32] & (1u << (id%32));
+    }
+
+    /// Keep track of the accessed properties, the roles are the working set
+    inline void markRead(MetaProperty *mr) {
+        if (isRead(mr->propId))
+            return;
+
+        m_lRead[mr->propId/32] |= 1u << (mr->propId%32);
+
+        if (mr->flags & MetaProperty::Flags::IS_ROLE)
+            m_lUsed << mr;
+    }
+
     ContextAdapterFactory* q_ptr;
 };
 
@@ -181,6 +319,8 @@ public:
     // layer of vTable instead of a static list. It goes against the
     // documentation, but that's on purpose.
     virtual QVariant getProperty(AbstractItemAdapter* item, uint id, const QModelIndex& index) const override;
+    virtual void getProperties(AbstractItemAdapter* item, const QVector<uint>& ids, const QModelIndex& index, QVector<QVariant>& values) const override;
+    virtual void setProperty(AbstractItemAdapter* item, uint id, const QVariant& value) const override;
     virtual uint size() const override;
     virtual QByteArray getPropertyName(uint id) const override;
 
@@ -197,6 +337,12 @@ ContextAdapterFactory::ContextAdapterFactory(FactoryFunctor f) : d_ptr(new Conte
 
 ContextAdapterFactory::~ContextAdapterFactory()
 {
+    if (d_ptr->m_pMetaType)
+        d_ptr->m_pMetaType->release();
+
+    free(d_ptr->m_lGroupMapping);
+    free(d_ptr->m_lRead);
+
     delete d_ptr;
 }
 
@@ -211,6 +357,12 @@ bool ContextExtension::supportCaching(uint id) const
     return true;
 }
 
+QVector<QByteArray> ContextExtension::roleDependencies(uint id) const
+{
+    Q_UNUSED(id)
+    return {};
+}
+
 QVector<QByteArray>& ContextExtension::propertyNames() const
 {
     static QVector<QByteArray> r;
@@ -222,6 +374,12 @@ QByteArray ContextExtension::getPropertyName(uint id) const
     return propertyNames()[id];
 }
 
+void ContextExtension::getProperties(AbstractItemAdapter* item, const QVector<uint>& ids, const QModelIndex& index, QVector<QVariant>& values) const
+{
+    for (int i = 0; i < ids.size(); i++)
+        values[i] = getProperty(item, ids[i], index);
+}
+
 void ContextExtension::setProperty(AbstractItemAdapter* item, uint id, const QVariant& value) const
 {
     Q_UNUSED(item)
@@ -229,27 +387,50 @@ void ContextExtension::setProperty(AbstractItemAdapter* item, uint id, const QVa
     Q_UNUSED(value)
 }
 
-void ContextExtension::changeProperty(AbstractItemAdapter* item, uint id)
+int ContextExtension::structuralDependencies(uint id) const
 {
-    Q_UNUSED(item)
     Q_UNUSED(id)
-    Q_ASSERT(false);
-/*
-    const auto metaRole = &d_ptr->d_ptr->m_pMetaType->roles[id];
-    Q_ASSERT(metaRole);
+    return StructureFlags::NONE;
+}
 
-    auto mo = d_ptr->d_ptr->m_pMetaType->m_pMetaObject;
+void ContextExtension::changeProperty(AbstractItemAdapter* item, uint id) const
+{
+    Q_ASSERT(item && d_ptr->d_ptr);
+    Q_ASSERT(id < size());
 
-    index()*/
+    // Without a delegate, there is nothing to notify
+    if (item->s_ptr->m_pMetadata)
+        item->s_ptr->m_pMetadata->contextAdapter()->dismissCache(this, id);
+}
+
+void ContextAdapter::dismissCache(const ContextExtension* e, int id)
+{
+    // Nothing was read yet
+    if (!d_ptr)
+        return;
+
+    Q_ASSERT(e->d_ptr->d_ptr == m_pFactory);
+
+    d_ptr->refresh(&d_ptr->m_pMetaType->roles[e->d_ptr->m_Offset + id]);
 }
 
 void ContextAdapter::flushCache()
 {
-    for (uint i = 0; i < d_ptr->m_pMetaType->propertyCount; i++) {
-        if (d_ptr->m_lVariants[i])
-            delete d_ptr->m_lVariants[i];
+    // Nothing was ever read
+    if (!d_ptr)
+        return;
 
-        d_ptr->m_lVariants[i] = nullptr;
+    const uint count = d_ptr->m_pMetaType->propertyCount;
+
+    for (uint w = 0; w*32 < count; w++) {
+        // Only the few properties used by the delegate are ever cached
+        if (!d_ptr->m_lValid[w])
+            continue;
+
+        for (uint i = w*32; i < count && i < (w+1)*32; i++) {
+            if (d_ptr->isCached(i))
+                d_ptr->dismiss(i);
+        }
     }
 }
 
@@ -264,23 +445,40 @@ void AbstractItemAdapter::dismissCacheEntry(ContextExtension* e, int id)
     Q_ASSERT(e->d_ptr->d_ptr->m_lGroups[e->d_ptr->m_Id] == e);
     Q_ASSERT(id >= 0 && id < e->size());
 
-    dx->m_lVariants[e->d_ptr->m_Offset + id] = nullptr;
+    dx->dismiss(e->d_ptr->m_Offset + id);
 }
 
 QVariant RoleGroup::getProperty(AbstractItemAdapter* item, uint id, const QModelIndex& index) const
 {
     Q_UNUSED(item)
-    const auto metaRole = &d_ptr->m_pMetaType->roles[id];
+    return index.data(d_ptr->m_pMetaType->roles[id].roleId);
+}
 
-    // Keep track of the accessed roles
-    if (!(metaRole->flags & MetaProperty::Flags::READ)) {
-        d_ptr->m_pMetaType->used << metaRole;
-        //qDebug() << "\n NEW ROLE!" << (*metaRole->name) << d_ptr->m_pMetaType->used.size();
+void RoleGroup::getProperties(AbstractItemAdapter* item, const QVector<uint>& ids, const QModelIndex& index, QVector<QVariant>& values) const
+{
+    if (!d_ptr->m_pMulti) {
+        ContextExtension::getProperties(item, ids, index, values);
+        return;
     }
 
-    metaRole->flags |= MetaProperty::Flags::READ;
+    QVector<int> roles(ids.size());
+
+    for (int i = 0; i < ids.size(); i++)
+        roles[i] = d_ptr->m_pMetaType->roles[ids[i]].roleId;
+
+    d_ptr->m_pMulti->multiData(index, roles, values);
+}
+
+void RoleGroup::setProperty(AbstractItemAdapter* item, uint id, const QVariant& value) const
+{
+    const QModelIndex idx = item->index();
 
-    return index.data(metaRole->roleId);
+    // The model notifies the change with `dataChanged`
+    if (idx.isValid()) {
+        const_cast<QAbstractItemModel*>(idx.model())->setData(
+            idx, value, d_ptr->m_pMetaType->roles[id].roleId
+        );
+    }
 }
 
 uint RoleGroup::size() const
@@ -299,62 +497,280 @@ const QMetaObject *DynamicContext::metaObject() const
     return m_pMetaType->m_pMetaObject;
 }
 
-int DynamicContext::qt_metacall(QMetaObject::Call call, int id, void **argv)
+QVariant DynamicContext::fetch(uint id) const
 {
-    if (!m_Mutex.try_lock())
-        return -1;
+    const auto group = &d_ptr->m_lGroupMapping[id];
+    Q_ASSERT(group->ptr);
+
+    // Use a special function for the role case. It's only known at runtime.
+    return group->ptr->getProperty(m_pBuilder->item(), id - group->offset, currentIndex());
+}
+
+QModelIndex DynamicContext::currentIndex() const
+{
+    return m_pBuilder->item() ? m_pBuilder->item()->index() : QModelIndex(m_pBuilder->m_Index);
+}
+
+bool DynamicContext::prefetch()
+{
+    QVarLengthArray<uint, 32> ids;
+
+    for (const auto mr : qAsConst(d_ptr->m_lUsed)) {
+        if (supportsCache(mr->propId) && !isCached(mr->propId))
+            ids.append(mr->propId);
+    }
+
+    // Not worth it
+    if (ids.size() < 2)
+        return false;
+
+    if (!currentIndex().isValid())
+        return false;
+
+    // The properties of each group are contiguous
+    std::sort(ids.begin(), ids.end());
+
+    QVector<QVariant> values;
+    fetchMany(ids, values);
+
+    for (int i = 0; i < ids.size(); i++) {
+        store(ids[i], values[i]);
+        setCached(ids[i]);
+    }
+
+    return true;
+}
+
+void DynamicContext::fetchMany(const QVarLengthArray<uint, 32>& ids, QVector<QVariant>& values) const
+{
+    const QModelIndex idx = currentIndex();
+
+    values.resize(ids.size());
+
+    QVector<uint>     local;
+    QVector<QVariant> groupValues;
+
+    for (int i = 0; i < ids.size();) {
+        const auto group = &d_ptr->m_lGroupMapping[ids[i]];
+
+        local.resize(0);
+
+        for (int j = i; j < ids.size() && d_ptr->m_lGroupMapping[ids[j]].ptr == group->ptr; j++)
+            local << ids[j] - group->offset;
+
+        groupValues.fill(QVariant(), local.size());
+
+        group->ptr->getProperties(m_pBuilder->item(), local, idx, groupValues);
+
+        for (int k = 0; k < local.size(); k++)
+            values[i+k] = groupValues[k];
+
+        i += local.size();
+    }
+}
+
+void DynamicContext::rebind()
+{
+    QVarLengthArray<uint, 32> cached, changed;
+
+    for (uint i = 0; i < m_pMetaType->propertyCount; i++) {
+        if (isCached(i))
+            cached.append(i);
+        else if (d_ptr->isRead(i))
+            changed.append(i); // There is no previous value to compare
+    }
+
+    if (!cached.isEmpty()) {
+        if (currentIndex().isValid()) {
+            QVector<QVariant> values;
+            fetchMany(cached, values);
+
+            // Delegates of similar rows often share many values
+            for (int i = 0; i < cached.size(); i++) {
+                if (equals(cached[i], values[i]))
+                    continue;
+
+                store(cached[i], values[i]);
+                changed.append(cached[i]);
+            }
+        }
+        else {
+            for (uint id : qAsConst(cached)) {
+                dismiss(id);
+                changed.append(id);
+            }
+        }
+    }
+
+    const auto mo = m_pMetaType->m_pMetaObject;
+
+    for (uint id : qAsConst(changed))
+        QMetaObject::activate(this, mo, m_pMetaType->roles[id].signalId, nullptr);
+}
+
+/// Write a value into a moc style return value of the given type
+static void writeValue(int type, const QVariant& v, void *out)
+{
+    switch(type) {
+        case QMetaType::Int:
+            *static_cast<int*>(out) = v.toInt();
+            break;
+        case QMetaType::Double:
+            *static_cast<double*>(out) = v.toDouble();
+            break;
+        case QMetaType::Bool:
+            *static_cast<bool*>(out) = v.toBool();
+            break;
+        case QMetaType::QString:
+            *static_cast<QString*>(out) = v.toString();
+            break;
+        default:
+            *static_cast<QVariant*>(out) = v;
+    }
+}
+
+void DynamicContext::store(uint id, const QVariant& v)
+{
+    auto slot = &m_lValues[id];
+
+    switch(m_pMetaType->roles[id].type) {
+        case QMetaType::Int:
+            slot->i = v.toInt();
+            break;
+        case QMetaType::Double:
+            slot->d = v.toDouble();
+            break;
+        case QMetaType::Bool:
+            slot->b = v.toBool();
+            break;
+        case QMetaType::QString:
+            slot->s = v.toString();
+            break;
+        default:
+            slot->v = v;
+    }
+}
+
+void DynamicContext::load(uint id, void *out) const
+{
+    const auto slot = &m_lValues[id];
+
+    switch(m_pMetaType->roles[id].type) {
+        case QMetaType::Int:
+            *static_cast<int*>(out) = slot->i;
+            break;
+        case QMetaType::Double:
+            *static_cast<double*>(out) = slot->d;
+            break;
+        case QMetaType::Bool:
+            *static_cast<bool*>(out) = slot->b;
+            break;
+        case QMetaType::QString:
+            *static_cast<QString*>(out) = slot->s;
+            break;
+        default:
+            *static_cast<QVariant*>(out) = slot->v;
+    }
+}
+
+bool DynamicContext::equals(uint id, const QVariant& v) const
+{
+    const auto slot = &m_lValues[id];
+
+    switch(m_pMetaType->roles[id].type) {
+        case QMetaType::Int:
+            return slot->i == v.toInt();
+        case QMetaType::Double:
+            return slot->d == v.toDouble();
+        case QMetaType::Bool:
+            return slot->b == v.toBool();
+        case QMetaType::QString:
+            return slot->s == v.toString();
+        default:
+            return slot->v == v;
+    }
+}
+
+bool DynamicContext::refresh(MetaProperty *mr)
+{
+    const uint id = mr->propId;
+
+    if (isCached(id)) {
+        // Many models send dataChanged without any actual change. Re-running
+        // all the bindings would be much more expensive than comparing.
+        const QVariant v = fetch(id);
+
+        if (equals(id, v))
+            return false;
+
+        store(id, v);
+    }
+    else if (!d_ptr->isRead(mr->propId)) {
+        // Nothing can depend on it yet
+        return false;
+    }
+
+    QMetaObject::activate(this, m_pMetaType->m_pMetaObject, mr->signalId, nullptr);
 
+    return true;
+}
 
+int DynamicContext::qt_metacall(QMetaObject::Call call, int id, void **argv)
+{
     const int realId = id - m_pMetaType->m_pMetaObject->propertyOffset();
 
     //qDebug() << "META" << id << realId << call << QMetaObject::ReadProperty;
-    if (realId < 0) {
-        m_Mutex.unlock();
+    if (realId < 0)
         return QObject::qt_metacall(call, id, argv);
-    }
 
     if (call == QMetaObject::ReadProperty) {
         if (Q_UNLIKELY(((size_t)realId) >= m_pMetaType->propertyCount)) {
             Q_ASSERT(false);
-            m_Mutex.unlock();
             return -1;
         }
 
-        const auto group = &m_pMetaType->m_lGroupMapping[realId];
-        Q_ASSERT(group->ptr);
+        // Like the moc, argv[0] points to a value of the property type
+        const bool supportsCache = this->supportsCache(realId);
 
-        const QModelIndex idx = m_pBuilder->item() ? m_pBuilder->item()->index() : m_Index;
-
-        const bool supportsCache = m_Cache &&
-            (m_pMetaType->m_pCacheMap[realId/8] & (1 << (realId % 8)));
-
-        // Use a special function for the role case. It's only known at runtime.
-        QVariant *value = m_lVariants[realId] && supportsCache
-            ? m_lVariants[realId] : new QVariant(
-                group->ptr->getProperty(m_pBuilder->item(), realId - group->offset, idx));
+        // Fast path, nothing to fetch and nothing to allocate
+        if (supportsCache && isCached(realId)) {
+            load(realId, argv[0]);
+            return -1;
+        }
 
-        if (supportsCache && !m_lVariants[realId])
-            m_lVariants[realId] = value;
+        // Keep track of the accessed properties
+        d_ptr->markRead(&m_pMetaType->roles[realId]);
 
-        QMetaType::construct(QMetaType::QVariant, argv[0], value->data());
+        const QVariant v = fetch(realId);
 
-//         if (!supportsCache)
-//             delete value;
+        if (supportsCache) {
+            store(realId, v);
+            setCached(realId);
+            load(realId, argv[0]);
+        }
+        else
+            writeValue(m_pMetaType->roles[realId].type, v, argv[0]);
     }
     else if (call == QMetaObject::WriteProperty) {
-        //qDebug() << "SET" << argv[0];
+        if (Q_UNLIKELY(((size_t)realId) >= m_pMetaType->propertyCount)) {
+            Q_ASSERT(false);
+            return -1;
+        }
+
+        const auto group = &d_ptr->m_lGroupMapping[realId];
+        Q_ASSERT(group->ptr);
 
-        //FIXME enable setData
-        //const QModelIndex idx = m_pBuilder->item() ? m_pBuilder->item()->index() : m_Index;
-        //Q_ASSERT(false); //TODO call setData
-        //const int roleId = m_hIdMapper.value(realId);
-        //m_Index.model()->setData(
-        //    m_Index, roleId, QVariant(property.typeId, argv[0])
-        //);
-        //m_lUsedProperties << roleId;
+        // Like the moc, argv[0] points to a value of the property type
+        const int type = m_pMetaType->roles[realId].type;
+        const QVariant v = type == QMetaType::QVariant ?
+            *reinterpret_cast<QVariant*>(argv[0]) : QVariant(type, argv[0]);
+
+        // The roles are written to the model, the other extensions notify the
+        // change with `changeProperty`
+        if (auto item = m_pBuilder->item())
+            group->ptr->setProperty(item, realId - group->offset, v);
 
         *reinterpret_cast<int*>(argv[2]) = 1;  // setProperty return value
-        QMetaObject::activate(this, m_pMetaType->m_pMetaObject, realId, nullptr);
     }
     else if (call == QMetaObject::InvokeMetaMethod) {
         int sigId = id - m_pMetaType->m_pMetaObject->methodOffset();
@@ -363,8 +779,6 @@ int DynamicContext::qt_metacall(QMetaObject::Call call, int id, void **argv)
         return -1;
     }
 
-    m_Mutex.unlock();
-
     return -1;
 }
 
@@ -380,19 +794,144 @@ DynamicMetaType::DynamicMetaType(const QHash<int, QByteArray>& rls) :
 roleCount(rls.size())
 {}
 
+DynamicMetaType::~DynamicMetaType()
+{
+    for (size_t i = 0; i < roleCount; i++)
+        delete roles[i].name;
+
+    delete[] roles;
+    free(m_pCacheMap);
+    free(m_pMetaObject);
+}
+
+/// The metatypes currently in use, indexed by ContextAdapterFactoryPrivate::key
+static QHash<QByteArray, DynamicMetaType*>& metaTypes()
+{
+    static QHash<QByteArray, DynamicMetaType*> h;
+    return h;
+}
+
+DynamicMetaType* DynamicMetaType::acquire(ContextAdapterFactoryPrivate* d, const QHash<int, QByteArray>& rls)
+{
+    const QByteArray k = d->key(rls);
+
+    auto mt = metaTypes().value(k);
+
+    if (!mt) {
+        mt = new DynamicMetaType(rls);
+        mt->m_Key = k;
+        d->m_pMetaType = mt;
+        d->initGroup(rls);
+        metaTypes()[k] = mt;
+    }
+
+    mt->m_RefCount++;
+
+    return mt;
+}
+
+void DynamicMetaType::release()
+{
+    Q_ASSERT(m_RefCount > 0);
+
+    if (--m_RefCount)
+        return;
+
+    metaTypes().remove(m_Key);
+    delete this;
+}
+
+/**
+ * The metaobject only depends on the property names and on which ones can be
+ * cached. The role group is always the first one and its names are the roles.
+ */
+QByteArray ContextAdapterFactoryPrivate::key(const QHash<int, QByteArray>& rls) const
+{
+    QList<int> ids = rls.keys();
+    std::sort(ids.begin(), ids.end());
+
+    QByteArray ret;
+
+    for (int id : qAsConst(ids))
+        ret += QByteArray::number(id) + '=' + rls[id] + ':'
+            + QByteArray::number(m_hTypes.value(id)) + ';';
+
+    for (int i = 1; i < m_lGroups.size(); i++) {
+        const auto g = m_lGroups[i];
+        ret += '|';
+
+        for (uint j = 0; j < g->size(); j++)
+            ret += g->getPropertyName(j) + (g->supportCaching(j) ? "+;" : "-;");
+    }
+
+    return ret;
+}
+
+/**
+ * Use a few rows of the model to guess the role types.
+ *
+ * A role is only unboxed when all the sampled values are valid and share the
+ * same type. Otherwise a role which is sometimes empty (or has many types)
+ * would be coerced to the type of the first row. The roles declared using
+ * setRoleTypes() are not guessed.
+ *
+ * The rows which were not sampled can still be empty, an unboxed role then
+ * reads as the default value of its type rather than `undefined`.
+ */
+void ContextAdapterFactoryPrivate::inferTypes(const QHash<int, QByteArray>& rls)
+{
+    static constexpr const int SAMPLE_COUNT = 4;
+
+    m_hTypes.clear();
+
+    // The first, last and a few rows in between
+    QVarLengthArray<QModelIndex, SAMPLE_COUNT> samples;
+    const int rows = m_pModel->rowCount();
+
+    for (int i = 0; i < SAMPLE_COUNT && i < rows; i++) {
+        const int row = rows <= SAMPLE_COUNT ?
+            i : (i * (rows - 1)) / (SAMPLE_COUNT - 1);
+
+        samples.append(m_pModel->index(row, 0));
+    }
+
+    for (auto i = rls.constBegin(); i != rls.constEnd(); i++) {
+        int type = m_hRoleTypes.value(i.value(), QMetaType::UnknownType);
+
+        if (type == QMetaType::UnknownType && !samples.isEmpty()) {
+            type = samples[0].data(i.key()).userType();
+
+            for (int j = 1; j < samples.size() && type != QMetaType::UnknownType; j++) {
+                if (samples[j].data(i.key()).userType() != type)
+                    type = QMetaType::UnknownType;
+            }
+        }
+
+        switch(type) {
+            case QMetaType::Int:
+            case QMetaType::Double:
+            case QMetaType::Bool:
+            case QMetaType::QString:
+                break;
+            default:
+                type = QMetaType::QVariant;
+        }
+
+        m_hTypes[i.key()] = type;
+    }
+}
+
 /// Populate a vTable with the propertyId -> group object
-void ContextAdapterFactoryPrivate::initGroup(const QHash<int, QByteArray>& rls)
+void ContextAdapterFactoryPrivate::initMapping()
 {
-    Q_ASSERT(!m_pMetaType->m_GroupInit);
+    const size_t count = m_pMetaType->propertyCount;
 
-    for (auto group : qAsConst(m_lGroups))
-        m_pMetaType->propertyCount += group->size();
+    m_lGroupMapping = (GroupMetaData*) malloc(sizeof(GroupMetaData) * count);
 
-    m_pMetaType->m_lGroupMapping = (GroupMetaData*) malloc(
-        sizeof(GroupMetaData) * m_pMetaType->propertyCount
-    );
+    const size_t words = count/32 + (count%32 ? 1 : 0);
+    m_lRead = (quint32*) calloc(words ? words : 1, sizeof(quint32));
 
-    uint offset(0), realId(0), groupId(0);
+    uint offset(0), groupId(0);
 
     for (auto group : qAsConst(m_lGroups)) {
         Q_ASSERT(!group->d_ptr->d_ptr);
@@ -403,11 +942,58 @@ void ContextAdapterFactoryPrivate::initGroup(const QHash<int, QByteArray>& rls)
         const uint gs = group->size();
 
         for (uint i = 0; i < gs; i++)
-            m_pMetaType->m_lGroupMapping[offset+i] = {group, offset};
+            m_lGroupMapping[offset+i] = {group, offset};
 
         offset += gs;
     }
-    Q_ASSERT(offset == m_pMetaType->propertyCount);
+    Q_ASSERT(offset == count);
+
+    initDependencies();
+}
+
+/// Map the roles to the extension properties computed from them
+void ContextAdapterFactoryPrivate::initDependencies()
+{
+    const auto mt = m_pMetaType;
+
+    for (auto group : qAsConst(m_lGroups)) {
+        const uint offset = group->d_ptr->m_Offset;
+
+        for (uint j = 0; j < group->size(); j++) {
+            const auto deps = group->roleDependencies(j);
+
+            for (const auto& name : deps) {
+                for (size_t r = 0; r < mt->roleCount; r++) {
+                    if (*mt->roles[r].name != name)
+                        continue;
+
+                    m_hDependents[mt->roles[r].roleId] << offset + j;
+
+                    if (!m_lComputed.contains(offset + j))
+                        m_lComputed << offset + j;
+                }
+            }
+
+            const int flags = group->structuralDependencies(j);
+
+            if (flags & ContextExtension::StructureFlags::ROW)
+                m_lRowDependents << offset + j;
+
+            if (flags & ContextExtension::StructureFlags::CHILDREN)
+                m_lChildrenDependents << offset + j;
+        }
+    }
+}
+
+/// Build the metaobject and the property metadata
+void ContextAdapterFactoryPrivate::initGroup(const QHash<int, QByteArray>& rls)
+{
+    Q_ASSERT(!m_pMetaType->m_GroupInit);
+
+    uint realId(0);
+
+    for (auto group : qAsConst(m_lGroups))
+        m_pMetaType->propertyCount += group->size();
 
     // Add a bitfield to store the properties that need to skip the cache
     const int fieldSize = m_pMetaType->propertyCount / 8 + (m_pMetaType->propertyCount%8?1:0);
@@ -433,6 +1019,7 @@ void ContextAdapterFactoryPrivate::initGroup(const QHash<int, QByteArray>& rls)
         r->roleId = i.key();
         r->name   = new QByteArray(i.value());
         r->flags |= MetaProperty::Flags::IS_ROLE;
+        r->type   = m_hTypes.value(i.key(), QMetaType::QVariant);
 
         m_pMetaType->m_hRoleIds[i.key()] = r;
     }
@@ -449,7 +1036,7 @@ void ContextAdapterFactoryPrivate::initGroup(const QHash<int, QByteArray>& rls)
             r->propId   = id;
             const auto name = g->getPropertyName(j);
 
-            auto property = builder.addProperty(name, "QVariant");
+            auto property = builder.addProperty(name, QMetaType::typeName(r->type));
             property.setWritable(true);
 
             auto signal = builder.addSignal(name + "Changed()");
@@ -470,15 +1057,51 @@ DynamicContext::DynamicContext(ContextAdapterFactory* cm) :
     Q_ASSERT(m_pMetaType);
     Q_ASSERT(m_pMetaType->roleCount <= m_pMetaType->propertyCount);
 
-    m_lVariants = (QVariant**) malloc(sizeof(QVariant*)*m_pMetaType->propertyCount);
+    // The context can outlive its factory, keep the slot layout alive
+    m_pMetaType->m_RefCount++;
+
+    const size_t count = m_pMetaType->propertyCount;
+    const size_t words = count/32 + (count%32 ? 1 : 0);
+
+    // A single block, the values first to keep them aligned
+    void *block = malloc(sizeof(ValueSlot)*count + sizeof(quint32)*words);
+
+    m_lValues = static_cast<ValueSlot*>(block);
+    m_lValid  = reinterpret_cast<quint32*>(m_lValues + count);
+
+    for (size_t i = 0; i < count; i++) {
+        switch(m_pMetaType->roles[i].type) {
+            case QMetaType::QString:
+                new (&m_lValues[i].s) QString();
+                break;
+            case QMetaType::QVariant:
+                new (&m_lValues[i].v) QVariant();
+                break;
+            default:
+                m_lValues[i].d = 0;
+        }
+    }
 
-    //TODO SIMD this
-    for (uint i = 0; i < m_pMetaType->propertyCount; i++)
-        m_lVariants[i] = nullptr;
+    memset(m_lValid, 0, sizeof(quint32)*words);
 }
 
 DynamicContext::~DynamicContext()
-{}
+{
+    for (size_t i = 0; i < m_pMetaType->propertyCount; i++) {
+        switch(m_pMetaType->roles[i].type) {
+            case QMetaType::QString:
+                m_lValues[i].s.~QString();
+                break;
+            case QMetaType::QVariant:
+                m_lValues[i].v.~QVariant();
+                break;
+        }
+    }
+
+    free(m_lValues);
+
+    m_pMetaType->release();
+}
 
 //FIXME delete the metatype now that it's invalid.
 //     if (m_pMetaType) {
@@ -491,54 +1114,70 @@ DynamicContext::~DynamicContext()
 
 bool ContextAdapter::updateRoles(const QVector<int> &modified) const
 {
-    if (!d_ptr->d_ptr->m_pMetaType)
+    if (!d_ptr || !d_ptr->m_pMetaType)
         return false;
 
     bool ret = false;
 
     if (!modified.isEmpty()) {
         for (auto r : qAsConst(modified)) {
-            if (auto mr = d_ptr->d_ptr->m_pMetaType->m_hRoleIds.value(r)) {
-                // This works because the role offset is always 0
-                if (d_ptr->m_lVariants[mr->propId]) {
-                    delete d_ptr->m_lVariants[mr->propId];
-                    d_ptr->m_lVariants[mr->propId] = nullptr;
-                    QMetaMethod m = d_ptr->metaObject()->method(mr->signalId);
-                    m.invoke(d_ptr);
-                    ret |= ret;
-                }
-            }
+            auto mr = d_ptr->m_pMetaType->m_hRoleIds.value(r);
+
+            // Outside of the working set, nothing can depend on it
+            if (mr && d_ptr->d_ptr->isRead(mr->propId))
+                ret |= d_ptr->refresh(mr);
+
+            // The extension properties computed from this role
+            const auto deps = d_ptr->d_ptr->m_hDependents.value(r);
+
+            for (uint id : deps)
+                ret |= d_ptr->refresh(&d_ptr->m_pMetaType->roles[id]);
         }
     }
     else {
         // Only update the roles known to have an impact
-        for (auto mr : qAsConst(d_ptr->d_ptr->m_pMetaType->used)) {
-            // Use `READ` instead of checking the cache because it could have
-            // been dismissed for many reasons.
-            if ((!d_ptr->m_Cache) || mr->flags & MetaProperty::Flags::READ) {
-                if (auto v = d_ptr->m_lVariants[mr->propId])
-                    delete v;
+        for (auto mr : qAsConst(d_ptr->d_ptr->m_lUsed))
+            ret |= d_ptr->refresh(mr);
 
-                d_ptr->m_lVariants[mr->propId] = nullptr;
+        for (uint id : qAsConst(d_ptr->d_ptr->m_lComputed))
+            ret |= d_ptr->refresh(&d_ptr->m_pMetaType->roles[id]);
+    }
 
-                //FIXME this should work, but it doesn't
-                auto mo = d_ptr->d_ptr->m_pMetaType->m_pMetaObject;
-                const int methodId = mo->methodOffset() + mr->signalId;
-                QMetaMethod m = mo->method(methodId);
-                //m.invoke(d_ptr);
-                Q_ASSERT(m.name() == (*mr->name)+"Changed");
+    return ret;
+}
 
-                //FIXME this should also work, but also doesn't
-                //QMetaObject::activate(d_ptr, mo, mr->signalId, nullptr);
+void ContextAdapterFactory::setRoleTypes(const QHash<QByteArray, int>& types)
+{
+    Q_ASSERT(!d_ptr->m_pMetaType);
 
-                //FIXME Use this for now, but it prevent setData from being implemented
-                d_ptr->setProperty(*mr->name, 0x1337);
+    if (d_ptr->m_pMetaType) {
+        qWarning() << "It is not possible to set the role types after creating a builder";
+        return;
+    }
 
-                QMetaObject::activate(d_ptr, mo, mr->signalId, nullptr);
+    d_ptr->m_hRoleTypes = types;
+}
 
-                ret = true;
-            }
-        }
+QHash<QByteArray, int> ContextAdapterFactory::roleTypes() const
+{
+    return d_ptr->m_hRoleTypes;
+}
+
+bool ContextAdapter::updateStructure(int flags) const
+{
+    if (!d_ptr)
+        return false;
+
+    bool ret = false;
+
+    if (flags & ContextExtension::StructureFlags::ROW) {
+        for (uint id : qAsConst(m_pFactory->m_lRowDependents))
+            ret |= d_ptr->refresh(&d_ptr->m_pMetaType->roles[id]);
+    }
+
+    if (flags & ContextExtension::StructureFlags::CHILDREN) {
+        for (uint id : qAsConst(m_pFactory->m_lChildrenDependents))
+            ret |= d_ptr->refresh(&d_ptr->m_pMetaType->roles[id]);
     }
 
     return ret;
@@ -552,6 +1191,7 @@ QAbstractItemModel *ContextAdapterFactory::model() const
 void ContextAdapterFactory::setModel(QAbstractItemModel *m)
 {
     d_ptr->m_pModel = m;
+    d_ptr->m_pMulti = qobject_cast<MultiRoleModel*>(m);
 }
 
 void ContextAdapterFactoryPrivate::finish()
@@ -563,8 +1203,10 @@ void ContextAdapterFactoryPrivate::finish()
 
     const auto roles = m_pModel->roleNames();
 
-    m_pMetaType = new DynamicMetaType(roles);
-    initGroup(roles);
+    inferTypes(roles);
+
+    m_pMetaType = DynamicMetaType::acquire(this, roles);
+    initMapping();
 }
 
 void ContextAdapterFactory::addContextExtension(ContextExtension* pg)
@@ -586,7 +1228,7 @@ QSet<QByteArray> ContextAdapterFactory::usedRoles() const
 
     QSet<QByteArray> ret;
 
-    for (const auto mr : qAsConst(d_ptr->m_pMetaType->used)) {
+    for (const auto mr : qAsConst(d_ptr->m_lUsed)) {
         if (mr->roleId != -1)
             ret << *mr->name;
     }
@@ -594,6 +1236,16 @@ QSet<QByteArray> ContextAdapterFactory::usedRoles() const
     return ret;
 }
 
+bool ContextAdapterFactory::isRoleUsed(int role) const
+{
+    if (!d_ptr->m_pMetaType)
+        return false;
+
+    const auto mr = d_ptr->m_pMetaType->m_hRoleIds.value(role);
+
+    return (mr && d_ptr->isRead(mr->propId)) || d_ptr->m_hDependents.contains(role);
+}
+
 ContextAdapter*
 ContextAdapterFactory::createAdapter(FactoryFunctor f, QQmlContext *parentContext) const
 {
@@ -601,24 +1253,33 @@ ContextAdapterFactory::createAdapter(FactoryFunctor f, QQmlContext *parentContex
 
     Q_ASSERT(!ret->d_ptr);
 
+    // The DynamicContext is created when the QML context is needed
     d_ptr->finish();
-    ret->d_ptr = new DynamicContext(const_cast<ContextAdapterFactory*>(this));
-    ret->d_ptr->d_ptr = d_ptr;
-    ret->d_ptr->setParent(parentContext);
-    ret->d_ptr->m_pBuilder   = ret;
-    ret->d_ptr->m_pParentCtx = parentContext;
-
-    //HACK QtQuick ignores
-    ret->d_ptr->m_Conn = QObject::connect(ret->d_ptr, &QObject::destroyed, ret->d_ptr, [ret, this, parentContext]() {
+    ret->m_pFactory   = d_ptr;
+    ret->m_pParentCtx = parentContext;
+
+    return ret;
+}
+
+DynamicContext* ContextAdapter::dynamicContext() const
+{
+    if (d_ptr)
+        return d_ptr;
+
+    Q_ASSERT(m_pFactory);
+
+    d_ptr = new DynamicContext(m_pFactory->q_ptr);
+    d_ptr->d_ptr      = m_pFactory;
+    d_ptr->m_pBuilder = const_cast<ContextAdapter*>(this);
+    d_ptr->setParent(m_pParentCtx);
+
+    //HACK QtQuick ignores the ownership, it will be created again when needed
+    d_ptr->m_Conn = QObject::connect(d_ptr, &QObject::destroyed, d_ptr, [this]() {
         qWarning() << "Rebuilding the cache because QtQuick bugs trashed it";
-        ret->d_ptr = new DynamicContext(const_cast<ContextAdapterFactory*>(this));
-        ret->d_ptr->d_ptr = d_ptr;
-        ret->d_ptr->setParent(parentContext);
-        ret->d_ptr->m_pBuilder   = ret;
-        ret->d_ptr->m_pParentCtx = parentContext;
+        d_ptr = nullptr;
     });
 
-    return ret;
+    return d_ptr;
 }
 
 ContextAdapter* ContextAdapterFactory::createAdapter(QQmlContext *parentContext) const
@@ -633,6 +1294,9 @@ ContextAdapter::ContextAdapter(QQmlContext *parentContext)
 
 ContextAdapter::~ContextAdapter()
 {
+    if (!d_ptr)
+        return;
+
     if (d_ptr->m_pCtx)
         d_ptr->m_pCtx->setContextObject(nullptr);
 
@@ -645,38 +1309,60 @@ ContextAdapter::~ContextAdapter()
 
 bool ContextAdapter::isCacheEnabled() const
 {
-    return d_ptr->m_Cache;
+    return m_Cache;
 }
 
 void ContextAdapter::setCacheEnabled(bool v)
 {
-    d_ptr->m_Cache = v;
+    m_Cache = v;
 }
 
 QModelIndex ContextAdapter::index() const
 {
-    return d_ptr->m_Index;
+    return m_Index;
 }
 
-void ContextAdapter::setModelIndex(const QModelIndex& index)
+void ContextAdapter::setModelIndex(const QModelIndex& index, bool notify)
 {
-    const bool hasIndex = d_ptr->m_Index.isValid();
+    m_Index = index;
+
+    // Nothing can depend on the previous index yet
+    if (!d_ptr)
+        return;
 
-    if (d_ptr->m_Cache)
+    // Without a QQmlContext there is no binding to notify
+    if (!(notify && d_ptr->m_pCtx)) {
         flushCache();
+        return;
+    }
+
+    d_ptr->rebind();
+}
 
-    d_ptr->m_Index = index;
+void ContextAdapter::invalidate()
+{
+    if (!d_ptr || !d_ptr->m_pMetaType)
+        return;
 
-    if (hasIndex)
-        updateRoles({});
+    flushCache();
+    d_ptr->prefetch();
+
+    // The signals are created in the same order as the properties
+    auto mo = d_ptr->m_pMetaType->m_pMetaObject;
+
+    for (uint i = 0; i < d_ptr->m_pMetaType->propertyCount; i++)
+        QMetaObject::activate(d_ptr, mo, d_ptr->m_pMetaType->roles[i].signalId, nullptr);
 }
 
 QQmlContext* ContextAdapter::context() const
 {
-    Q_ASSERT(d_ptr);
+    dynamicContext();
 
     if (!d_ptr->m_pCtx) {
-        d_ptr->m_pCtx = new QQmlContext(d_ptr->m_pParentCtx, d_ptr->parent());
+        // The roles used by the previous delegates will most likely be read
+        d_ptr->prefetch();
+
+        d_ptr->m_pCtx = new QQmlContext(m_pParentCtx, d_ptr->parent());
         d_ptr->m_pCtx->setContextObject(d_ptr);
         d_ptr->m_pCtx->engine()->setObjectOwnership(
             d_ptr, QQmlEngine::CppOwnership
@@ -691,12 +1377,12 @@ QQmlContext* ContextAdapter::context() const
 
 QObject *ContextAdapter::contextObject() const
 {
-    return d_ptr;
+    return dynamicContext();
 }
 
 bool ContextAdapter::isActive() const
 {
-    return d_ptr->m_pCtx;
+    return d_ptr && d_ptr->m_pCtx;
 }
 
 AbstractItemAdapter* ContextAdapter::item() const
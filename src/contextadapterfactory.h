@@ -19,6 +19,7 @@
 
 // Qt
 #include <QtCore/QObject>
+#include <QtCore/QHash>
 class QAbstractItemModel;
 class QQmlContext;
 class QQuickItem;
@@ -71,8 +72,36 @@ public:
      */
     void addContextExtension(ContextExtension* pg);
 
+    /**
+     * The working set of roles.
+     *
+     * These are the roles read by at least one delegate. The others are
+     * ignored by the prefetching and the change notifications.
+     */
     QSet<QByteArray> usedRoles() const;
 
+    /// If `role` is part of the working set
+    bool isRoleUsed(int role) const;
+
+    /**
+     * Declare the type of some roles.
+     *
+     * The value is a QMetaType::Type. Only `Int`, `Double`, `Bool` and
+     * `QString` roles are exposed with a concrete type, everything else stays
+     * a QVariant. The roles not in this map have their type inferred from a
+     * few rows of the model. Use `QMetaType::QVariant` to disable the
+     * inference for a role which doesn't always have the same type.
+     *
+     * A typed role has no `undefined` state. When the model returns an
+     * invalid QVariant, QML gets the default value of the type (`0`,
+     * `false` or `""`). Keep the roles which can be empty as `QVariant` if
+     * the delegates need to tell the difference.
+     *
+     * This must be called before the first adapter is created.
+     */
+    void setRoleTypes(const QHash<QByteArray, int>& types);
+    QHash<QByteArray, int> roleTypes() const;
+
     /**
      * Create a context adapter.
      *
@@ -21,6 +21,7 @@
 #include <QtCore/QVariant>
 #include <QtCore/QByteArray>
 #include <QtCore/QModelIndex>
+#include <QtCore/QVector>
 
 class ContextExtensionPrivate;
 
@@ -36,6 +37,12 @@ class ContextExtensionPrivate;
 class ContextExtension
 {
 public:
+    /// The changes of the model structure a property can depend on
+    enum StructureFlags {
+        NONE     = 0x0     , /*!< Only the index itself                     */
+        ROW      = 0x1 << 0, /*!< The row changes when the siblings move    */
+        CHILDREN = 0x1 << 1, /*!< Children are inserted, removed or moved   */
+    };
 
     explicit ContextExtension();
     virtual ~ContextExtension() {}
@@ -80,6 +87,30 @@ public:
         */
     virtual bool supportCaching(uint id) const;
 
+    /**
+        * The name of the model roles the property is computed from.
+        *
+        * The value of a cached property is computed once per row. When one
+        * of these roles changes, it is computed again and the change is only
+        * notified if the value is different.
+        *
+        * The default implementation returns no roles, the property then only
+        * changes when the context is bound to another index or when
+        * changeProperty is called.
+        */
+    virtual QVector<QByteArray> roleDependencies(uint id) const;
+
+    /**
+        * The StructureFlags of the property.
+        *
+        * A cached property computed from the model structure (like the row
+        * or the number of children) is only computed again when the view
+        * receives one of these structural changes.
+        *
+        * The default implementation returns NONE.
+        */
+    virtual int structuralDependencies(uint id) const;
+
     /**
         * The id comes from propertyNames.
         *
@@ -88,6 +119,16 @@ public:
         */
     virtual QVariant getProperty(AbstractItemAdapter* item, uint id, const QModelIndex& index) const = 0;
 
+    /**
+        * Fetch many properties at once.
+        *
+        * This is called when a context is bound to a new index. `values`
+        * has the same size as `ids`. The default implementation calls
+        * getProperty for each id. Implement it when many properties come
+        * from the same expensive lookup.
+        */
+    virtual void getProperties(AbstractItemAdapter* item, const QVector<uint>& ids, const QModelIndex& index, QVector<QVariant>& values) const;
+
     /**
         * Optionally make the property read/write.
         */
@@ -95,8 +136,11 @@ public:
 
     /**
         * Notify that content of this property has changed.
+        *
+        * The cached value is computed again and the notify signal is emitted
+        * if it changed.
         */
-    void changeProperty(AbstractItemAdapter* item, uint id);
+    void changeProperty(AbstractItemAdapter* item, uint id) const;
 
     ContextExtensionPrivate *d_ptr;
 };
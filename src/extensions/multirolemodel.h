@@ -0,0 +1,49 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#pragma once
+
+// Qt
+#include <QtCore/QObject>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
+#include <QtCore/QModelIndex>
+
+/**
+ * Optional interface for models able to fetch many roles in one call.
+ *
+ * When a delegate is bound to an index, all the roles it uses are fetched
+ * at once. By default this still calls QAbstractItemModel::data() once per
+ * role. Models where multiple roles come from the same expensive lookup
+ * should implement this interface and declare it with
+ * `Q_INTERFACES(MultiRoleModel)`.
+ */
+class MultiRoleModel
+{
+public:
+    virtual ~MultiRoleModel() {}
+
+    /**
+     * Fetch the `roles` of `index`.
+     *
+     * `values` has the same size as `roles`, all elements are invalid when
+     * this is called. Leave them invalid for unknown roles.
+     */
+    virtual void multiData(const QModelIndex& index, const QVector<int>& roles, QVector<QVariant>& values) const = 0;
+};
+
+Q_DECLARE_INTERFACE(MultiRoleModel, "org.kde.playground.kquickview.MultiRoleModel")
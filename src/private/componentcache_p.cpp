@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#include "componentcache_p.h"
+
+// Qt
+#include <QtCore/QHash>
+#include <QtCore/QDebug>
+#include <QQmlEngine>
+#include <QQmlComponent>
+
+using ComponentMap = QHash<QByteArray, QQmlComponent*>;
+
+// Only accessed from the GUI thread
+static QHash<QQmlEngine*, ComponentMap> s_hCache;
+
+QQmlComponent *ComponentCache::get(QQmlEngine *engine, const char *source)
+{
+    Q_ASSERT(engine);
+
+    auto cache = s_hCache.find(engine);
+
+    if (cache == s_hCache.end()) {
+        cache = s_hCache.insert(engine, {});
+
+        // The components are children of the engine, only forget them
+        QObject::connect(engine, &QObject::destroyed, [engine]() {
+            s_hCache.remove(engine);
+        });
+    }
+
+    const auto key = QByteArray::fromRawData(source, qstrlen(source));
+
+    if (auto c = cache->value(key))
+        return c;
+
+    auto c = new QQmlComponent(engine, engine);
+    c->setData(source, {});
+
+    if (c->isError())
+        qWarning() << c->errorString();
+
+    cache->insert(QByteArray(source), c);
+
+    return c;
+}
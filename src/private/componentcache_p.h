@@ -0,0 +1,40 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#pragma once
+
+// Qt
+class QQmlEngine;
+class QQmlComponent;
+
+/**
+ * Compile the small QML snippets used internally once per QQmlEngine.
+ *
+ * Applications with many small views would otherwise parse and compile the
+ * same string for each instance. The components are children of the engine
+ * and are freed along with it.
+ */
+class ComponentCache final
+{
+public:
+    /**
+     * Get the component for `source`, it is compiled on first use.
+     *
+     * @param source The QML code, it is also used as the cache key
+     */
+    static QQmlComponent *get(QQmlEngine *engine, const char *source);
+};
@@ -0,0 +1,194 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#include "delegatepool_p.h"
+
+// Qt
+#include <QtCore/QTimer>
+#include <QtCore/QAbstractItemModel>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QQuickWindow>
+
+// KQuickItemViews
+#include <viewport.h>
+#include <viewbase.h>
+#include <adapters/modeladapter.h>
+#include <adapters/contextadapter.h>
+#include <private/viewport_p.h>
+#include <private/indexmetadata_p.h>
+
+DelegatePool::DelegatePool(Viewport *vp) : QObject(vp), m_pViewport(vp)
+{
+    auto ma   = vp->modelAdapter();
+    auto view = ma->view();
+
+    // About one delegate per frame, a 0 ms timer would starve the input
+    // events and the animations of the other items.
+    m_pTimer = new QTimer(this);
+    m_pTimer->setInterval(16);
+    connect(m_pTimer, &QTimer::timeout, this, &DelegatePool::slotIdle);
+
+    connect(view, &QQuickItem::windowChanged, this, &DelegatePool::slotWindowChanged);
+    connect(view, &Flickable::draggingChanged, this, &DelegatePool::slotInteraction);
+    connect(view, &Flickable::movingChanged, this, &DelegatePool::slotInteraction);
+
+    // The wheel and the keyboard scroll without dragging. `currentY` cannot
+    // be used, it also changes when the application scrolls the view.
+    view->installEventFilter(this);
+
+    // The pre-created delegates use the previous component or roles
+    connect(ma, &ModelAdapter::modelChanged, this, &DelegatePool::slotReset);
+    connect(ma, &ModelAdapter::delegateChanged, this, &DelegatePool::slotReset);
+
+    slotWindowChanged(view->window());
+}
+
+DelegatePool::~DelegatePool()
+{
+    clear();
+}
+
+bool DelegatePool::isEnabled() const
+{
+    const auto ma = m_pViewport->modelAdapter();
+
+    return (!m_IsInteracting)
+        && ma->recyclingMode() != ModelAdapter::RecyclingMode::NoRecycling
+        && ma->poolSize() > m_lEntries.size()
+        && ma->delegate()
+        && ma->rawModel()
+        && ma->rawModel()->rowCount();
+}
+
+QPair<ContextAdapter*, QQuickItem*> DelegatePool::take()
+{
+    if (m_lEntries.isEmpty())
+        return {};
+
+    return m_lEntries.takeLast();
+}
+
+void DelegatePool::clear()
+{
+    m_pTimer->stop();
+
+    for (const auto &e : qAsConst(m_lEntries)) {
+        discard(e.second);
+        delete e.first;
+    }
+
+    m_lEntries.clear();
+}
+
+int DelegatePool::size() const
+{
+    return m_lEntries.size();
+}
+
+void DelegatePool::discard(QQuickItem *container)
+{
+    if (!container)
+        return;
+
+    delete container->property("content").value<QObject*>();
+    delete container;
+}
+
+void DelegatePool::slotWindowChanged(QQuickWindow *w)
+{
+    if (m_pWindow)
+        disconnect(m_pWindow, &QQuickWindow::frameSwapped,
+            this, &DelegatePool::slotFrameSwapped);
+
+    // It is emitted from the render thread
+    if ((m_pWindow = w))
+        connect(w, &QQuickWindow::frameSwapped,
+            this, &DelegatePool::slotFrameSwapped, Qt::QueuedConnection);
+}
+
+void DelegatePool::slotFrameSwapped()
+{
+    // Only the first frame matters, after that it is driven by the timer
+    disconnect(m_pWindow, &QQuickWindow::frameSwapped,
+        this, &DelegatePool::slotFrameSwapped);
+
+    m_HasPresented = true;
+
+    if (isEnabled())
+        m_pTimer->start();
+}
+
+void DelegatePool::slotIdle()
+{
+    if (!isEnabled()) {
+        m_pTimer->stop();
+        return;
+    }
+
+    auto ma = m_pViewport->modelAdapter();
+
+    // Bind it to an existing index, otherwise all role bindings would be
+    // evaluated against `undefined` and print warnings.
+    auto adapter = IndexMetadata::createContextAdapter(m_pViewport);
+    adapter->setModelIndex(ma->rawModel()->index(0, 0));
+
+    auto container = m_pViewport->s_ptr->createDelegate(adapter->context());
+
+    if (!container) {
+        delete adapter;
+        m_pTimer->stop();
+        return;
+    }
+
+    container->setVisible(false);
+
+    m_lEntries << qMakePair(adapter, container);
+}
+
+bool DelegatePool::eventFilter(QObject *watched, QEvent *event)
+{
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wswitch-enum"
+    switch(event->type()) {
+        case QEvent::Wheel:
+        case QEvent::KeyPress:
+        case QEvent::MouseButtonPress:
+        case QEvent::TouchBegin:
+            slotInteraction();
+            break;
+        default:
+            break;
+    }
+    #pragma GCC diagnostic pop
+
+    return QObject::eventFilter(watched, event);
+}
+
+void DelegatePool::slotInteraction()
+{
+    m_IsInteracting = true;
+    m_pTimer->stop();
+}
+
+void DelegatePool::slotReset()
+{
+    clear();
+
+    // Before the first frame, wait for it like the first time
+    if (m_HasPresented && isEnabled())
+        m_pTimer->start();
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#pragma once
+
+// Qt
+#include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QVector>
+#include <QtCore/QPointer>
+class QTimer;
+class QQuickItem;
+class QQuickWindow;
+
+// KQuickItemViews
+class Viewport;
+class ContextAdapter;
+
+/**
+ * Create delegates ahead of time while the application is idle.
+ *
+ * The first delegate instances are the most expensive to create. Once the
+ * first frame has been presented, this pool uses the idle time to create
+ * `ModelAdapter::poolSize` delegates. They are bound to an existing index
+ * and reassigned to the first IndexMetadata needing a context.
+ *
+ * It stops as soon as the user starts interacting with the view. From that
+ * point, any slowdown would be visible. Programmatic scrolling doesn't count
+ * as an interaction.
+ *
+ * It is only enabled when the ModelAdapter::recyclingMode allows delegates
+ * to be reused.
+ */
+class DelegatePool final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DelegatePool(Viewport *vp);
+    virtual ~DelegatePool();
+
+    /**
+     * Take a pre-created delegate container and the context adapter it uses.
+     *
+     * Both are null when the pool is empty.
+     */
+    QPair<ContextAdapter*, QQuickItem*> take();
+
+    /**
+     * Free all pre-created delegates.
+     */
+    void clear();
+
+    int size() const;
+
+    /**
+     * Free a delegate container which was never displayed.
+     */
+    static void discard(QQuickItem *container);
+
+protected:
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QVector<QPair<ContextAdapter*, QQuickItem*>> m_lEntries;
+
+    QPointer<QQuickWindow> m_pWindow;
+    Viewport *m_pViewport     { nullptr };
+    QTimer   *m_pTimer        { nullptr };
+    bool      m_IsInteracting {  false  };
+    bool      m_HasPresented  {  false  };
+
+    bool isEnabled() const;
+
+private Q_SLOTS:
+    void slotWindowChanged(QQuickWindow *w);
+    void slotFrameSwapped();
+    void slotIdle();
+    void slotInteraction();
+    void slotReset();
+};
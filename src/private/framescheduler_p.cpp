@@ -0,0 +1,339 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#include "framescheduler_p.h"
+
+// Qt
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtQuick/QQuickWindow>
+
+// LibStdC++
+#include <algorithm>
+#include <limits>
+
+// KQuickItemViews
+#include <viewbase.h>
+#include <viewport.h>
+#include <adapters/contextadapter.h>
+#include <private/statetracker/viewitem_p.h>
+
+#define BIT(a) (1u << static_cast<int>(a))
+
+constexpr const int FrameScheduler::DEFAULT_BUDGET;
+
+FrameScheduler::FrameScheduler(ViewBase *v) : QObject(v), m_pView(v)
+{
+    connect(v, &QQuickItem::windowChanged, this, &FrameScheduler::slotWindowChanged);
+    slotWindowChanged(v->window());
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    for (auto i = m_hPending.constBegin(); i != m_hPending.constEnd(); ++i)
+        i.key()->setScheduler(nullptr);
+}
+
+FrameScheduler::Pending &FrameScheduler::enqueue(IndexMetadata *md)
+{
+    Q_ASSERT((!md->scheduler()) || md->scheduler() == this);
+
+    md->setScheduler(this);
+    requestFrame();
+
+    return m_hPending[md];
+}
+
+void FrameScheduler::schedule(IndexMetadata *md, IndexMetadata::LoadAction a)
+{
+    if (!m_Budget) {
+        md->performAction(a);
+        return;
+    }
+
+    enqueue(md).load |= BIT(a);
+}
+
+void FrameScheduler::schedule(IndexMetadata *md, IndexMetadata::ViewAction a)
+{
+    if (!m_Budget) {
+        md->performAction(a);
+        return;
+    }
+
+    enqueue(md).view |= BIT(a);
+}
+
+void FrameScheduler::schedule(IndexMetadata *md, IndexMetadata::GeometryAction a)
+{
+    if (!m_Budget) {
+        md->performAction(a);
+        return;
+    }
+
+    enqueue(md).geometry |= BIT(a);
+}
+
+void FrameScheduler::scheduleRoles(IndexMetadata *md, const QVector<int> &roles)
+{
+    if (!m_Budget) {
+        md->contextAdapter()->updateRoles(roles);
+        md->performAction(IndexMetadata::ViewAction::UPDATE);
+        return;
+    }
+
+    auto &p = enqueue(md);
+
+    p.view |= BIT(IndexMetadata::ViewAction::UPDATE);
+
+    // Merge with the roles that already changed since the last frame
+    if (roles.isEmpty()) {
+        p.allRoles = true;
+        p.roles.clear();
+    }
+    else if (!p.allRoles) {
+        for (int r : qAsConst(roles)) {
+            if (!p.roles.contains(r))
+                p.roles << r;
+        }
+    }
+
+    p.hasRoles = true;
+}
+
+void FrameScheduler::scheduleOnce(QObject *key, const std::function<void()> &f, Phase phase)
+{
+    requestFrame();
+
+    auto &l = m_lOnce[(int)phase];
+
+    for (auto &e : l) {
+        if (e.first == key) {
+            e.second = f;
+            return;
+        }
+    }
+
+    l << qMakePair(QPointer<QObject>(key), f);
+}
+
+void FrameScheduler::cancelOnce(QObject *key)
+{
+    for (auto &l : m_lOnce) {
+        l.erase(std::remove_if(l.begin(), l.end(), [key](const auto &e) {
+            return e.first == key;
+        }), l.end());
+    }
+}
+
+void FrameScheduler::runOnce(Phase phase)
+{
+    // The callbacks are allowed to schedule more of them for the next frame
+    const auto once = m_lOnce[(int)phase];
+    m_lOnce[(int)phase].clear();
+
+    for (const auto &e : qAsConst(once)) {
+        if (e.first)
+            e.second();
+    }
+}
+
+void FrameScheduler::cancel(IndexMetadata *md)
+{
+    Q_ASSERT(md->scheduler() == this);
+
+    m_hPending.remove(md);
+    md->setScheduler(nullptr);
+}
+
+void FrameScheduler::flush()
+{
+    runOnce(Phase::BEFORE_ACTIONS);
+
+    // Applying the actions is allowed to schedule more of them
+    while ((!m_IsDraining) && !m_hPending.isEmpty())
+        drain(0);
+
+    runOnce(Phase::AFTER_ACTIONS);
+}
+
+int FrameScheduler::budget() const
+{
+    return m_Budget;
+}
+
+void FrameScheduler::setBudget(int ms)
+{
+    m_Budget = std::max(0, ms);
+
+    // There is nothing to defer to anymore
+    if (!m_Budget)
+        flush();
+}
+
+int FrameScheduler::pendingCount() const
+{
+    return m_hPending.size();
+}
+
+qreal FrameScheduler::distance(IndexMetadata *md) const
+{
+    // Without a geometry there is no way to tell, serve the others first
+    if (!md->isValid())
+        return std::numeric_limits<qreal>::max();
+
+    const QRectF vp  = md->viewport()->currentRect();
+    const QRectF geo = md->decoratedGeometry();
+
+    const qreal dx = std::max({0.0, vp.left() - geo.right() , geo.left() - vp.right() });
+    const qreal dy = std::max({0.0, vp.top()  - geo.bottom(), geo.top()  - vp.bottom()});
+
+    return dx + dy;
+}
+
+void FrameScheduler::apply(IndexMetadata *md, const Pending &p)
+{
+    for (int i = 0; p.geometry >> i; i++) {
+        if (p.geometry & (1u << i))
+            md->performAction(static_cast<IndexMetadata::GeometryAction>(i));
+    }
+
+    // The delegate may have been detached (or pooled) since the action was
+    // scheduled, the view actions would then be invalid.
+    const auto vt = md->viewTracker();
+    const bool isAttached = vt && (
+           vt->state() == StateTracker::ViewItem::State::BUFFER
+        || vt->state() == StateTracker::ViewItem::State::ACTIVE
+    );
+
+    if (p.view && isAttached) {
+        if (p.hasRoles)
+            md->contextAdapter()->updateRoles(p.allRoles ? QVector<int>() : p.roles);
+
+        for (int i = 0; p.view >> i; i++) {
+            if ((p.view & (1u << i)) && md->viewTracker())
+                md->performAction(static_cast<IndexMetadata::ViewAction>(i));
+        }
+    }
+
+    // DETACH can free the IndexMetadata, so it has to come last
+    const uint load = p.load & ~BIT(IndexMetadata::LoadAction::DETACH);
+
+    for (int i = 0; load >> i; i++) {
+        if (load & (1u << i))
+            md->performAction(static_cast<IndexMetadata::LoadAction>(i));
+    }
+
+    if (p.load & BIT(IndexMetadata::LoadAction::DETACH))
+        md->performAction(IndexMetadata::LoadAction::DETACH);
+}
+
+void FrameScheduler::drain(qint64 budget)
+{
+    if (m_IsDraining)
+        return;
+
+    m_IsDraining = true;
+
+    QElapsedTimer t;
+    t.start();
+
+    // The priority is computed now rather than when the action was scheduled
+    // since the viewport may have moved in between.
+    QVector<QPair<qreal, IndexMetadata*>> queue;
+    queue.reserve(m_hPending.size());
+
+    for (auto i = m_hPending.constBegin(); i != m_hPending.constEnd(); ++i)
+        queue << qMakePair(distance(i.key()), i.key());
+
+    std::stable_sort(queue.begin(), queue.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    for (const auto &e : qAsConst(queue)) {
+        if (budget > 0 && t.elapsed() >= budget)
+            break;
+
+        // A previous action may have destroyed (and canceled) this one, the
+        // pointer is only compared, never dereferenced, before the lookup.
+        auto it = m_hPending.find(e.second);
+
+        if (it == m_hPending.end())
+            continue;
+
+        const Pending p = *it;
+        m_hPending.erase(it);
+        e.second->setScheduler(nullptr);
+
+        apply(e.second, p);
+    }
+
+    m_IsDraining = false;
+
+    // Carry the rest to the next frame
+    if (!m_hPending.isEmpty())
+        requestFrame();
+}
+
+void FrameScheduler::requestFrame()
+{
+    if (m_IsFrameRequested)
+        return;
+
+    m_IsFrameRequested = true;
+
+    // Queued since it is also called from `afterAnimating`, while the window
+    // is already in the middle of preparing a frame.
+    if (m_pWindow)
+        QMetaObject::invokeMethod(m_pWindow, "update", Qt::QueuedConnection);
+    else
+        QTimer::singleShot(0, this, &FrameScheduler::slotAfterAnimating);
+}
+
+void FrameScheduler::slotWindowChanged(QQuickWindow *w)
+{
+    if (m_pWindow)
+        disconnect(m_pWindow, &QQuickWindow::afterAnimating,
+            this, &FrameScheduler::slotAfterAnimating);
+
+    // `afterAnimating` is emitted in the GUI thread right before the scene
+    // graph synchronization, unlike `beforeSynchronizing` which comes from
+    // the render thread and cannot touch the items.
+    if ((m_pWindow = w))
+        connect(w, &QQuickWindow::afterAnimating,
+            this, &FrameScheduler::slotAfterAnimating);
+
+    m_IsFrameRequested = false;
+
+    if (!(m_hPending.isEmpty() && m_lOnce[0].isEmpty() && m_lOnce[1].isEmpty()))
+        requestFrame();
+}
+
+void FrameScheduler::slotAfterAnimating()
+{
+    m_IsFrameRequested = false;
+
+    runOnce(Phase::BEFORE_ACTIONS);
+
+    if (!m_hPending.isEmpty())
+        drain(m_Budget);
+
+    // The geometry changes applied by the actions are now visible
+    runOnce(Phase::AFTER_ACTIONS);
+}
+
+#undef BIT
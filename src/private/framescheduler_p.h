@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#pragma once
+
+// Qt
+#include <QtCore/QObject>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtCore/QPointer>
+class QQuickWindow;
+
+// LibStdC++
+#include <functional>
+
+// KQuickItemViews
+#include <private/indexmetadata_p.h>
+class ViewBase;
+
+/**
+ * Defer the state machine actions that don't need to be applied before the
+ * model signal handler returns.
+ *
+ * The actions are queued per IndexMetadata and applied when the window
+ * prepares the next frame. The elements closest to the viewport are served
+ * first and the queue stops draining once the frame budget is exhausted. The
+ * remaining actions are then carried to the next frame.
+ *
+ * The role reloads are queued here, and so is the delegate creation of the
+ * buffered rows outside of the viewport when the geometry is known ahead of
+ * time. The rows in the viewport are always loaded right away.
+ *
+ * Note that the structural changes (insertion, removal, moves) still have to
+ * be applied synchronously since the edges and the linked list must be
+ * consistent with the model once its signal returns.
+ *
+ * @see ViewBase::frameBudget
+ */
+class FrameScheduler final : public QObject
+{
+    Q_OBJECT
+public:
+    /// When the `scheduleOnce` callbacks are called
+    enum class Phase {
+        BEFORE_ACTIONS, /*!< Before the pending actions are applied */
+        AFTER_ACTIONS , /*!< Once the pending actions are applied   */
+    };
+
+    /// The frame budget (in milliseconds) until ViewBase::frameBudget is set
+    static constexpr const int DEFAULT_BUDGET = 5;
+
+    explicit FrameScheduler(ViewBase *v);
+    virtual ~FrameScheduler();
+
+    void schedule(IndexMetadata *md, IndexMetadata::LoadAction     a);
+    void schedule(IndexMetadata *md, IndexMetadata::ViewAction     a);
+    void schedule(IndexMetadata *md, IndexMetadata::GeometryAction a);
+
+    /**
+     * Schedule a ViewAction::UPDATE along with the roles to reload.
+     *
+     * @param roles The changed roles, an empty vector means all of them.
+     */
+    void scheduleRoles(IndexMetadata *md, const QVector<int> &roles);
+
+    /**
+     * Call `f` once when the next frame is prepared, before or after the
+     * pending actions are applied.
+     *
+     * Scheduling the same `key` again before that replaces the callback, so
+     * a burst of events only does the work once per frame. The callback is
+     * dropped if the key is destroyed first. Unlike the actions, it is
+     * deferred even when the budget is 0.
+     */
+    void scheduleOnce(QObject *key, const std::function<void()> &f,
+                      Phase phase = Phase::BEFORE_ACTIONS);
+
+    /// Drop the `scheduleOnce` callback of `key`, if any
+    void cancelOnce(QObject *key);
+
+    /**
+     * Forget the pending actions. It has to be called before the
+     * IndexMetadata is destroyed.
+     */
+    void cancel(IndexMetadata *md);
+
+    /**
+     * Apply all pending actions now, regardless of the budget.
+     */
+    void flush();
+
+    /// The time spent per frame (in milliseconds), 0 to disable the deferral
+    int budget() const;
+    void setBudget(int ms);
+
+    int pendingCount() const;
+
+private:
+    struct Pending {
+        uint         load     {  0  };
+        uint         view     {  0  };
+        uint         geometry {  0  };
+        bool         hasRoles {false};
+        bool         allRoles {false};
+        QVector<int> roles    {     };
+    };
+
+    QHash<IndexMetadata*, Pending> m_hPending;
+    using Callbacks = QVector<QPair<QPointer<QObject>, std::function<void()>>>;
+    Callbacks m_lOnce[2];
+    QPointer<QQuickWindow> m_pWindow;
+    ViewBase *m_pView            { nullptr };
+    int       m_Budget           { DEFAULT_BUDGET };
+    bool      m_IsFrameRequested {  false  };
+    bool      m_IsDraining       {  false  };
+
+    Pending &enqueue(IndexMetadata *md);
+    void requestFrame();
+    void drain(qint64 budget);
+    void runOnce(Phase phase);
+    void apply(IndexMetadata *md, const Pending &p);
+    qreal distance(IndexMetadata *md) const;
+
+private Q_SLOTS:
+    void slotWindowChanged(QQuickWindow *w);
+    void slotAfterAnimating();
+};
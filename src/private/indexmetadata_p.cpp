@@ -35,6 +35,8 @@
 #include "statetracker/index_p.h"
 #include "statetracker/selection_p.h"
 #include "statetracker/modelitem_p.h"
+#include "framescheduler_p.h"
+#include "delegatepool_p.h"
 
 class IndexMetadataPrivate
 {
@@ -49,6 +51,7 @@ public:
     StateTracker::Selection *m_pSelectionTracker { nullptr };
     ViewItemContextAdapter  *m_pContextAdapter   { nullptr };
     Viewport                *m_pViewport         { nullptr };
+    FrameScheduler          *m_pScheduler        { nullptr };
 
     // Attributes
     bool m_IsCollapsed {false}; //TODO change the default to true
@@ -76,7 +79,7 @@ public:
     virtual QModelIndex          index  () const override;
     virtual AbstractItemAdapter *item   () const override;
 
-    IndexMetadata* m_pGeometry;
+    IndexMetadata* m_pGeometry {nullptr};
 };
 
 #define A &IndexMetadataPrivate::
@@ -104,6 +107,9 @@ IndexMetadata::IndexMetadata(StateTracker::Index *idxT, Viewport *p) :
 
 IndexMetadata::~IndexMetadata()
 {
+    if (d_ptr->m_pScheduler)
+        d_ptr->m_pScheduler->cancel(this);
+
     if (d_ptr->m_pContextAdapter) {
         if (d_ptr->m_pContextAdapter->isActive())
             d_ptr->m_pContextAdapter->context()->setContextObject(nullptr);
@@ -121,12 +127,9 @@ void IndexMetadata::setViewTracker(StateTracker::ViewItem *i)
         d_ptr->m_pViewport->s_ptr->notifyRemoval(old->m_pMetadata);
     }
 
-    if ((d_ptr->m_pViewTracker = i)) {
+    // The context is created by `loadDelegate` when the item is instantiated
+    if ((d_ptr->m_pViewTracker = i))
         i->m_pMetadata = this;
-
-        // Assign the context object
-        contextAdapter()->context();
-    }
 }
 
 StateTracker::ViewItem *IndexMetadata::viewTracker() const
@@ -186,27 +189,56 @@ QRectF IndexMetadata::decoratedGeometry() const
 ContextAdapter* IndexMetadata::contextAdapter() const
 {
     if (!d_ptr->m_pContextAdapter) {
-        auto cm = d_ptr->m_pViewport->modelAdapter()->contextAdapterFactory();
-        d_ptr->m_pContextAdapter = cm->createAdapter<ViewItemContextAdapter>(
-            d_ptr->m_pViewport->modelAdapter()->view()->rootContext()
+        d_ptr->m_pContextAdapter = static_cast<ViewItemContextAdapter*>(
+            createContextAdapter(d_ptr->m_pViewport)
         );
-        d_ptr->m_pContextAdapter->m_pGeometry = const_cast<IndexMetadata*>(this);
 
-        // This will init the context now.
-        contextAdapter()->context();
+        d_ptr->m_pContextAdapter->m_pGeometry = const_cast<IndexMetadata*>(this);
     }
 
     return d_ptr->m_pContextAdapter;
 }
 
+ContextAdapter *IndexMetadata::createContextAdapter(Viewport *vp)
+{
+    auto cm = vp->modelAdapter()->contextAdapterFactory();
+
+    return cm->createAdapter<ViewItemContextAdapter>(
+        vp->modelAdapter()->view()->rootContext()
+    );
+}
+
+QQuickItem *IndexMetadata::takeWarmDelegate()
+{
+    // The pooled delegate is bound to the context of its own adapter
+    if (d_ptr->m_pContextAdapter)
+        return nullptr;
+
+    auto pool = d_ptr->m_pViewport->s_ptr->m_pPool;
+    const auto warm = pool ? pool->take() : QPair<ContextAdapter*, QQuickItem*>();
+
+    if (!warm.first)
+        return nullptr;
+
+    d_ptr->m_pContextAdapter = static_cast<ViewItemContextAdapter*>(warm.first);
+    d_ptr->m_pContextAdapter->m_pGeometry = this;
+
+    // Its properties still reflect the index used to pre-create it
+    d_ptr->m_pContextAdapter->invalidate();
+
+    return warm.second;
+}
+
 QModelIndex ViewItemContextAdapter::index() const
 {
-    return m_pGeometry->index();
+    // Until it is adopted, a pooled adapter uses `setModelIndex`
+    return m_pGeometry ? m_pGeometry->index() : ContextAdapter::index();
 }
 
 AbstractItemAdapter* ViewItemContextAdapter::item() const
 {
-    return m_pGeometry->viewTracker() ? m_pGeometry->viewTracker()->d_ptr : nullptr;
+    return m_pGeometry && m_pGeometry->viewTracker() ?
+        m_pGeometry->viewTracker()->d_ptr : nullptr;
 }
 
 bool IndexMetadata::isValid() const
@@ -254,7 +286,7 @@ QSizeF IndexMetadata::sizeHint()
             d_ptr->m_GeoTracker.setPosition(QPointF(0.0, prevGeo.y() + prevGeo.height()));
         }
         else if (isTopItem()) {
-            d_ptr->m_GeoTracker.setPosition(QPointF(0.0, 0.0));
+            d_ptr->m_GeoTracker.setPosition(d_ptr->m_pViewport->s_ptr->originOf(this));
             Q_ASSERT(d_ptr->m_GeoTracker.state() == StateTracker::Geometry::State::PENDING);
         }
     }
@@ -446,3 +478,13 @@ Viewport *IndexMetadata::viewport() const
 {
     return d_ptr->m_pViewport;
 }
+
+FrameScheduler *IndexMetadata::scheduler() const
+{
+    return d_ptr->m_pScheduler;
+}
+
+void IndexMetadata::setScheduler(FrameScheduler *s)
+{
+    d_ptr->m_pScheduler = s;
+}
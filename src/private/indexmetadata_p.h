@@ -21,6 +21,7 @@
 #include <QtCore/QRectF>
 #include <QtCore/QModelIndex>
 #include <QtCore/QItemSelectionModel>
+class QQuickItem;
 
 namespace StateTracker {
     class ViewItem;
@@ -33,6 +34,7 @@ namespace StateTracker {
 
 class ContextAdapter;
 class Viewport;
+class FrameScheduler;
 class SelectionAdapter;
 
 class IndexMetadataPrivate;
@@ -196,6 +198,30 @@ public:
 
     Viewport *viewport() const;
 
+    /// The scheduler holding deferred actions for this index (if any)
+    FrameScheduler *scheduler() const;
+    void setScheduler(FrameScheduler *s);
+
+    /**
+     * Take a delegate container created ahead of time and adopt its context
+     * adapter. Only the delegate loading uses it, so the pooled delegates
+     * are not used up by the rows which are never displayed.
+     *
+     * @return nullptr if the pool is empty or the context adapter already
+     *  exists
+     *
+     * @see DelegatePool
+     */
+    QQuickItem *takeWarmDelegate();
+
+    /**
+     * Create a context adapter which isn't yet bound to an IndexMetadata.
+     *
+     * It uses `ContextAdapter::setModelIndex` until it is adopted by
+     * `contextAdapter()`.
+     */
+    static ContextAdapter *createContextAdapter(Viewport *vp);
+
 private:
     IndexMetadataPrivate *d_ptr;
 };
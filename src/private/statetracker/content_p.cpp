@@ -26,6 +26,11 @@
 #include <private/viewport_p.h>
 #include <private/indexmetadata_p.h>
 #include <adapters/contextadapter.h>
+#include <adapters/modeladapter.h>
+#include <contextadapterfactory.h>
+#include <extensions/contextextension.h>
+#include <private/viewbase_p.h>
+#include <private/framescheduler_p.h>
 
 // Qt
 #include <QtCore/QDebug>
@@ -61,6 +66,9 @@ public:
 
     void reloadEdges();
 
+    /// Refresh the structural context properties after `first`
+    void notifyStructure(const QModelIndex& parent, int first);
+
     StateTracker::ModelItem *m_pRoot {nullptr};
 
     //TODO add a circular buffer to GC the items
@@ -99,6 +107,11 @@ public Q_SLOTS:
                             const QVector<int> &roles  );
     void slotRowsMoved     (const QModelIndex &p, int start, int end,
                             const QModelIndex &dest, int row);
+
+    // Called once the model is in its new state
+    void slotRowCountChanged(const QModelIndex& parent, int first, int last);
+    void slotRowsMovedAfter (const QModelIndex &p, int start, int end,
+                             const QModelIndex &dest, int row);
 };
 
 #define A &ContentPrivate::
@@ -277,7 +290,8 @@ void ContentPrivate::slotRowsInserted(const QModelIndex& parent, int first, int
         }
 
         //FIXME It can happen if the previous is out of the visible range
-        Q_ASSERT( e->previousSibling() || e->nextSibling() || e->effectiveRow() == 0);
+        // (or it is the first loaded row, it is not row 0 after a far jump)
+        Q_ASSERT( e->previousSibling() || e->nextSibling() || !prev);
 
         //TODO merge with bridgeGap
         if (prev) {
@@ -399,18 +413,39 @@ void ContentPrivate::slotRowsRemoved(const QModelIndex& parent, int first, int l
 //TODO optimize this
 void ContentPrivate::slotDataChanged(const QModelIndex& tl, const QModelIndex& br, const QVector<int> &roles)
 {
-    Q_UNUSED(roles)
     if (!q_ptr->isActive(tl.parent(), tl.row(), br.row()))
         return;
 
+    // The contexts ignore the roles no delegate ever read
+    QVector<int> used;
+
+    if (!roles.isEmpty()) {
+        const auto f = m_pViewport->modelAdapter()->contextAdapterFactory();
+
+        for (int r : qAsConst(roles)) {
+            if (f->isRoleUsed(r))
+                used << r;
+        }
+    }
+
+    // The geometry and size hint strategies don't read the roles through the
+    // context, they still need the UPDATE
+    const bool refreshContext = roles.isEmpty() || !used.isEmpty();
+
+    // The roles are reloaded when the next frame is prepared, closest first
+    auto s = m_pViewport->modelAdapter()->view()->s_ptr->scheduler();
+
     for (int i = tl.row(); i <= br.row(); i++) {
         const auto idx = m_pModelTracker->modelCandidate()->index(i, tl.column(), tl.parent());
-        if (auto tti = ttiForIndex(idx)) {
-            if (tti->metadata()->viewTracker()) {
-                tti->metadata()->contextAdapter()->updateRoles(roles);
-                tti->metadata() << IndexMetadata::ViewAction::UPDATE;
-            }
-        }
+        const auto tti = ttiForIndex(idx);
+
+        if ((!tti) || !tti->metadata()->viewTracker())
+            continue;
+
+        if (refreshContext)
+            s->scheduleRoles(tti->metadata(), used);
+        else
+            s->schedule(tti->metadata(), IndexMetadata::ViewAction::UPDATE);
     }
 }
 
@@ -583,6 +618,53 @@ void ContentPrivate::slotRowsMoved(const QModelIndex &parent, int start, int end
     //WARNING The indices still are in transition mode, do not use their value
 }
 
+void ContentPrivate::slotRowCountChanged(const QModelIndex& parent, int first, int last)
+{
+    Q_UNUSED(last)
+    notifyStructure(parent, first);
+}
+
+void ContentPrivate::slotRowsMovedAfter(const QModelIndex &parent, int start, int end,
+                                        const QModelIndex &destination, int row)
+{
+    Q_UNUSED(end)
+
+    if (parent == destination) {
+        notifyStructure(parent, std::min(start, row));
+        return;
+    }
+
+    notifyStructure(parent, start);
+    notifyStructure(destination, row);
+}
+
+/**
+ * The structural properties (like the row or the number of children) are
+ * cached in the context of each item. Rather than computing them every
+ * time, only refresh the ones of the loaded items this change affected.
+ */
+void ContentPrivate::notifyStructure(const QModelIndex& parent, int first)
+{
+    const auto pitem = parent.isValid() ? ttiForIndex(parent) : m_pRoot;
+
+    if (!pitem)
+        return;
+
+    // The number of children changed
+    if (pitem != m_pRoot && pitem->metadata()->viewTracker())
+        pitem->metadata()->contextAdapter()->updateStructure(
+            ContextExtension::StructureFlags::CHILDREN
+        );
+
+    // The siblings after `first` have a new row
+    for (auto i = pitem->firstChild(); i; i = i->nextSibling()) {
+        if (i->effectiveRow() >= first && i->metadata()->viewTracker())
+            i->metadata()->contextAdapter()->updateStructure(
+                ContextExtension::StructureFlags::ROW
+            );
+    }
+}
+
 QList<StateTracker::Index*> ContentPrivate::setTemporaryIndices(const QModelIndex &parent, int start, int end,
                                      const QModelIndex &destination, int row)
 {
@@ -936,6 +1018,12 @@ void StateTracker::Content::connectModel(QAbstractItemModel *m)
         &ContentPrivate::slotRowsMoved);
     QObject::connect(m, &QAbstractItemModel::dataChanged, d_ptr,
         &ContentPrivate::slotDataChanged);
+    QObject::connect(m, &QAbstractItemModel::rowsInserted, d_ptr,
+        &ContentPrivate::slotRowCountChanged);
+    QObject::connect(m, &QAbstractItemModel::rowsRemoved, d_ptr,
+        &ContentPrivate::slotRowCountChanged);
+    QObject::connect(m, &QAbstractItemModel::rowsMoved, d_ptr,
+        &ContentPrivate::slotRowsMovedAfter);
 
 #ifdef ENABLE_EXTRA_VALIDATION
     QObject::connect(m, &QAbstractItemModel::rowsMoved, d_ptr,
@@ -963,6 +1051,12 @@ void StateTracker::Content::disconnectModel(QAbstractItemModel *m)
         &ContentPrivate::slotRowsMoved);
     QObject::disconnect(m, &QAbstractItemModel::dataChanged, d_ptr,
         &ContentPrivate::slotDataChanged);
+    QObject::disconnect(m, &QAbstractItemModel::rowsInserted, d_ptr,
+        &ContentPrivate::slotRowCountChanged);
+    QObject::disconnect(m, &QAbstractItemModel::rowsRemoved, d_ptr,
+        &ContentPrivate::slotRowCountChanged);
+    QObject::disconnect(m, &QAbstractItemModel::rowsMoved, d_ptr,
+        &ContentPrivate::slotRowsMovedAfter);
 
 #ifdef ENABLE_EXTRA_VALIDATION
 //     QObject::disconnect(m, &QAbstractItemModel::rowsMoved, d_ptr,
@@ -1006,4 +1100,27 @@ void StateTracker::Content::forceInsert(const QModelIndex& parent, int first, in
     d_ptr->slotRowsInserted(parent, first, last);
 }
 
+/**
+ * Free all the loaded rows and load them again starting at `idx`.
+ *
+ * The rows above `idx` are loaded later, if the view gets to them.
+ *
+ * @param y The position of `idx`
+ */
+void StateTracker::Content::relocate(const QModelIndex& idx, qreal y)
+{
+    Q_ASSERT(idx.isValid() && !idx.parent().isValid());
+
+    d_ptr->slotCleanup();
+
+    // Set it once the old rows are gone, they still use the previous one
+    const auto s = d_ptr->m_pViewport->s_ptr;
+    s->m_OriginIndex = idx;
+    s->m_Origin      = y;
+
+    const int rc = d_ptr->m_pModelTracker->modelCandidate()->rowCount();
+
+    d_ptr->slotRowsInserted({}, idx.row(), rc - 1);
+}
+
 #include <statetracker/content_p.moc>
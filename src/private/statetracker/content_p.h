@@ -70,6 +70,7 @@ public:
     void perfromStateChange(Event e, IndexMetadata *md, StateTracker::ModelItem::State s);
     void forceInsert(const QModelIndex& idx);
     void forceInsert(const QModelIndex& parent, int first, int last);
+    void relocate(const QModelIndex& idx, qreal y);
 
     // Helpers
     IndexMetadata *metadataForIndex(const QModelIndex& idx) const;
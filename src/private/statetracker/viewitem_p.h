@@ -101,6 +101,28 @@ public:
 
     State state() const;
 
+    /**
+     * Free the QQuickItem while keeping the state. It is loaded again the
+     * next time it is accessed.
+     *
+     * The ACTIVE and BUFFER items outside of the viewport are evicted. The
+     * ACTIVE ones are restored when they intersect the viewport again, the
+     * BUFFER ones when they enter the view. Either way, the view `attach()`
+     * runs again with the new QQuickItem. The other actions must tolerate the
+     * missing QQuickItem.
+     *
+     * @see ModelAdapter::maxLiveDelegates
+     */
+    void evict();
+
+    // Least recently visible order, managed by ViewportSync
+    ViewItem *m_pPreviousLive {nullptr};
+    ViewItem *m_pNextLive     {nullptr};
+    bool      m_IsLive        { false };
+
+    /// Evicted or deferred, the view `attach()` has to run when it is loaded
+    bool      m_IsEvicted     { false };
+
     AbstractItemAdapter* d_ptr;
 private:
     State m_State {State::POOLED};
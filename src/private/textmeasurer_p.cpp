@@ -0,0 +1,104 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#include "textmeasurer_p.h"
+
+// Qt
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtGui/QFont>
+#include <QtGui/QTextLayout>
+#include <QtGui/QTextOption>
+
+struct MeasureKey
+{
+    QString text;
+    QString font;
+    qreal   width;
+    int     maxLines;
+
+    bool operator==(const MeasureKey& o) const {
+        return width == o.width && maxLines == o.maxLines
+            && font == o.font && text == o.text;
+    }
+};
+
+static uint qHash(const MeasureKey& k, uint seed = 0)
+{
+    return ::qHash(k.text, seed) ^ ::qHash(k.font, seed)
+        ^ ::qHash(k.width, seed) ^ uint(k.maxLines);
+}
+
+// Only accessed from the GUI thread
+static QCache<MeasureKey, QSizeF> s_Cache(4096);
+
+static QSizeF layoutText(const QString& text, const QFont& font, qreal width, int maxLines)
+{
+    QTextOption opt;
+    opt.setWrapMode(width > 0 ?
+        QTextOption::WrapAtWordBoundaryOrAnywhere : QTextOption::NoWrap
+    );
+
+    // QTextLayout doesn't handle line separators by itself
+    QString str = text;
+    str.replace(QLatin1Char('\n'), QChar::LineSeparator);
+
+    QTextLayout layout(str, font);
+    layout.setTextOption(opt);
+    layout.setCacheEnabled(false);
+
+    qreal h = 0, w = 0;
+    int count = 0;
+
+    layout.beginLayout();
+
+    forever {
+        if (maxLines > 0 && count == maxLines)
+            break;
+
+        QTextLine line = layout.createLine();
+
+        if (!line.isValid())
+            break;
+
+        if (width > 0)
+            line.setLineWidth(width);
+
+        h += line.height();
+        w  = qMax(w, line.naturalTextWidth());
+        count++;
+    }
+
+    layout.endLayout();
+
+    return {w, h};
+}
+
+QSizeF TextMeasurer::measure(const QString& text, const QFont& font, qreal width, int maxLines)
+{
+    const MeasureKey k {text, font.key(), width, maxLines};
+
+    if (auto s = s_Cache.object(k))
+        return *s;
+
+    const QSizeF ret = layoutText(text, font, width, maxLines);
+
+    s_Cache.insert(k, new QSizeF(ret));
+
+    return ret;
+}
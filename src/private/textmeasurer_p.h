@@ -0,0 +1,42 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#pragma once
+
+// Qt
+#include <QtCore/QSizeF>
+class QString;
+class QFont;
+
+/**
+ * Compute the size of wrapped text without a delegate nor the JS engine.
+ *
+ * The results are shared by all the SizeHintProxyModel instances. Most rows
+ * of most lists display the same few strings (dates, names, statuses), so
+ * they are cached by content, font, width and line count.
+ */
+class TextMeasurer final
+{
+public:
+    /**
+     * Measure `text` wrapped to `width`.
+     *
+     * @param width The available width, 0 or less means no wrapping
+     * @param maxLines The maximum number of lines, 0 means no limit
+     */
+    static QSizeF measure(const QString& text, const QFont& font, qreal width, int maxLines);
+};
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+#pragma once
+
+// Qt
+class QObject;
+
+class ViewBase;
+class FrameScheduler;
+
+/**
+ * Internal interface between the ViewBase and the adapters it owns.
+ *
+ * It is used for the housekeeping tasks that are shared by all the model
+ * adapters and viewports of a view.
+ */
+class ViewBaseSync final
+{
+public:
+    /**
+     * Free an object at a later time.
+     *
+     * The objects queued during an event loop iteration are freed together
+     * in the next one. This avoids posting one event for each destroyed
+     * delegate when large ranges of rows are removed.
+     *
+     * @see ViewBase::destructionBatchSize
+     */
+    void bury(QObject *o);
+
+    /**
+     * Free all the pending objects immediately.
+     */
+    void emptyGraveyard();
+
+    /**
+     * The scheduler for the state machine actions that can wait for the
+     * next frame.
+     *
+     * @see ViewBase::frameBudget
+     */
+    FrameScheduler *scheduler() const;
+
+    ViewBase *q_ptr;
+};
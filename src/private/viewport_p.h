@@ -20,6 +20,8 @@
 // Qt
 class QQmlComponent;
 class QQmlEngine;
+class QQmlContext;
+class QQuickItem;
 
 // KItemViews
 class Viewport;
@@ -27,13 +29,16 @@ class IndexMetadata;
 class AbstractItemAdapter;
 class GeoStrategySelector;
 class ViewBaseItemVariables;
+class DelegatePool;
 
 namespace StateTracker {
 class Content;
+class ViewItem;
 }
 
 #include <QtCore/QRectF>
 #include <QtCore/QModelIndex>
+#include <QtCore/QSet>
 
 #include "statetracker/geometry_p.h"
 
@@ -79,14 +84,87 @@ public:
     QQmlEngine    *engine();
     QQmlComponent *component();
 
+    /**
+     * Create the delegate wrapped in its container item.
+     *
+     * @param pctx The context holding the QModelIndex properties
+     * @return The container, it has no parent item.
+     */
+    QQuickItem *createDelegate(QQmlContext *pctx);
+
     IndexMetadata *metadataForIndex(const QModelIndex& idx) const;
 
+    /**
+     * From the widget, when the QQuickItem is created.
+     *
+     * It becomes the most recently visible delegate.
+     */
+    void notifyLoaded(StateTracker::ViewItem *item);
+
+    /**
+     * From the widget, when the QQuickItem is freed.
+     */
+    void notifyUnloaded(StateTracker::ViewItem *item);
+
+    /**
+     * From the widget, when it is moved. It then becomes the most recently
+     * visible delegate.
+     */
+    void touch(StateTracker::ViewItem *item);
+
+    /**
+     * Free the least recently visible delegates until the
+     * ModelAdapter::maxLiveDelegates budget is respected.
+     *
+     * The delegates intersecting the viewport are never freed.
+     */
+    void enforceDelegateBudget();
+
+    /**
+     * Free the live delegates outside of the viewport, keeping at most `max`
+     * of them (0 to free them all).
+     */
+    void evictOffscreen(int max);
+
+    /**
+     * The delegates of the rows outside of the viewport are created by the
+     * FrameScheduler within the frame budget.
+     *
+     * @return If the delegate creation was deferred
+     */
+    bool deferLoading(StateTracker::ViewItem *item);
+
+    /**
+     * The position of the first loaded row.
+     *
+     * After a far jump, it isn't the first row of the model. Its position is
+     * then computed from the ahead of time geometry of the rows above it.
+     */
+    QPointF originOf(IndexMetadata *md);
+
+    /**
+     * Load the freed delegates that are in the viewport again.
+     */
+    void restoreEvicted();
+
     Viewport *q_ptr;
     StateTracker::Content *m_pReflector {nullptr};
     GeoStrategySelector *m_pGeoAdapter  { nullptr };
+    DelegatePool        *m_pPool        { nullptr };
     std::function<AbstractItemAdapter*()> m_fFactory;
 
+    // Live delegates, from the least to the most recently visible
+    StateTracker::ViewItem *m_pFirstLive {nullptr};
+    StateTracker::ViewItem *m_pLastLive  {nullptr};
+    int                     m_LiveCount  {   0   };
+
+    // Delegates freed to respect the budget, their state is still ACTIVE/BUFFER
+    QSet<StateTracker::ViewItem*> m_lEvicted;
+
+    // The first row loaded by the last far jump and its position
+    QPersistentModelIndex m_OriginIndex;
+    qreal                 m_Origin { 0.0 };
+
 private:
     QQmlEngine    *m_pEngine    {nullptr};
-    QQmlComponent *m_pComponent {nullptr};
 };
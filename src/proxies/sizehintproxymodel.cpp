@@ -20,6 +20,7 @@
 // KQuickItemViews
 #include "adapters/contextadapter.h"
 #include "contextadapterfactory.h"
+#include "private/textmeasurer_p.h"
 
 // Qt
 #include <QJSValue>
@@ -28,6 +29,11 @@
 #include <QQmlContext>
 #include <QQmlExpression>
 #include <QtCore/QSizeF>
+#include <QtCore/QSet>
+#include <QtCore/QVarLengthArray>
+
+// LibStdC++
+#include <algorithm>
 
 class SizeHintProxyModelPrivate : public QObject
 {
@@ -44,11 +50,60 @@ public:
     QQmlContext           *m_pQmlContext       {nullptr};
     ContextAdapterFactory        *m_pContextAdapterFactory   {nullptr};
     ContextAdapter        *m_pContextAdapter   {nullptr};
-    QVariantMap            m_hCache            {       };
-
+    SizeHintProxyModel::SizeHintFunctor m_fSizeHint;
+    SizeHintProxyModel::SizeHintRangeFunctor m_fRangeSizeHint;
+    QSet<int>              m_lInvalidationIds  {       };
+    QString                m_TextRole          {       };
+    QFont                  m_TextFont          {       };
+    qreal                  m_TextWidth         {   0   };
+    int                    m_MaxLineCount      {   0   };
+    qreal                  m_ViewWidth         {   0   };
+    qreal                  m_BucketSize        {   1   };
+    int                    m_Bucket            {   0   };
+
+    struct CachedSize {
+        QSizeF size     {       };
+        int    bucket   {   0   };
+        bool   measured { false };
+    };
+
+    /// The cached sizes of a parent children and the nodes of their children
+    struct CacheNode {
+        ~CacheNode() { qDeleteAll(children); }
+
+        /// Indexed by column then by row
+        QVector<QVector<CachedSize>> rows;
+
+        /// Indexed by row, null when nothing is cached for its children
+        QVector<CacheNode*> children;
+    };
+
+    bool                   m_InvalidationDirty { true  };
+
+    /**
+     * The computed size of each measured row, as a tree following the model.
+     *
+     * The nodes are found by walking the rows of the parent chain, so when a
+     * parent moves, only the vector of its own parent node shifts and its
+     * children stay reachable. The structural changes shift or drop ranges
+     * of those vectors rather than scanning every entry.
+     *
+     * Entries measured for another width bucket are recomputed when they
+     * are next requested rather than all at once when the view is resized.
+     */
+    mutable CacheNode m_Cache;
 
     // Helpers
     int   roleIndex(const QString& name);
+    bool  isInvalidationRole(const QVector<int>& roles);
+    CacheNode *node(const QModelIndex& parent, bool create = false) const;
+    bool  isCacheEmpty() const;
+    void  clearCache();
+    void  insertRows(CacheNode *n, int first, int count);
+    void  removeRows(CacheNode *n, int first, int count, CacheNode **taken = nullptr);
+    void  fetchRange(const QModelIndex& parent, int first, int last, QSizeF* out);
+    bool  lookup(const QModelIndex& idx, QSizeF& out) const;
+    void  store(const QModelIndex& idx, const QSizeF& size);
     void  reloadContants();
     void  reloadContext(QAbstractItemModel *m);
     qreal evaluateForIndex(QQmlExpression* expr, const QModelIndex& idx);
@@ -58,12 +113,30 @@ public:
 
 public Q_SLOTS:
     void slotDataChanged(const QModelIndex& tl, const QModelIndex& bl, const QVector<int>& roles);
+    void slotRowsAboutToBeInserted(const QModelIndex& parent, int first, int last);
+    void slotRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+    void slotRowsAboutToBeMoved(const QModelIndex& parent, int start, int end,
+                                const QModelIndex& destination, int row);
+    void slotClear();
 };
 
 SizeHintProxyModel::SizeHintProxyModel(QObject* parent) : QIdentityProxyModel(parent),
     d_ptr(new SizeHintProxyModelPrivate())
 {
     d_ptr->q_ptr = this;
+
+    connect(this, &QAbstractItemModel::dataChanged,
+        d_ptr, &SizeHintProxyModelPrivate::slotDataChanged);
+    connect(this, &QAbstractItemModel::rowsAboutToBeInserted,
+        d_ptr, &SizeHintProxyModelPrivate::slotRowsAboutToBeInserted);
+    connect(this, &QAbstractItemModel::rowsAboutToBeRemoved,
+        d_ptr, &SizeHintProxyModelPrivate::slotRowsAboutToBeRemoved);
+    connect(this, &QAbstractItemModel::rowsAboutToBeMoved,
+        d_ptr, &SizeHintProxyModelPrivate::slotRowsAboutToBeMoved);
+    connect(this, &QAbstractItemModel::layoutAboutToBeChanged,
+        d_ptr, &SizeHintProxyModelPrivate::slotClear);
+    connect(this, &QAbstractItemModel::modelAboutToBeReset,
+        d_ptr, &SizeHintProxyModelPrivate::slotClear);
 }
 
 SizeHintProxyModel::~SizeHintProxyModel()
@@ -75,8 +148,10 @@ void SizeHintProxyModel::setSourceModel(QAbstractItemModel *newSourceModel)
 {
 
     d_ptr->reloadContext(newSourceModel);
-    d_ptr->m_ReloadContants = true;
+    d_ptr->m_ReloadContants    = true;
+    d_ptr->m_InvalidationDirty = true;
     d_ptr->m_hInvertedRoleNames.clear();
+    d_ptr->clearCache();
     QIdentityProxyModel::setSourceModel(newSourceModel);
     d_ptr->reloadContants();
 }
@@ -106,13 +181,13 @@ int SizeHintProxyModelPrivate::roleIndex(const QString& name)
             m_hInvertedRoleNames.insert(i.value(), i.key());
     }
 
-    return m_hInvertedRoleNames[n];
+    return m_hInvertedRoleNames.value(n, -1);
 }
 
 void SizeHintProxyModel::invalidateConstants()
 {
     d_ptr->m_ReloadContants = true;
-    d_ptr->m_hCache.clear();
+    d_ptr->clearCache();
 }
 
 QVariant SizeHintProxyModel::getRoleValue(const QModelIndex& idx, const QString& roleName) const
@@ -128,14 +203,207 @@ QStringList SizeHintProxyModel::invalidationRoles() const
 void SizeHintProxyModel::setInvalidationRoles(const QStringList& l)
 {
     d_ptr->m_lInvalidationRoles = l;
+    d_ptr->m_InvalidationDirty  = true;
+}
+
+bool SizeHintProxyModelPrivate::isInvalidationRole(const QVector<int>& roles)
+{
+    if (m_lInvalidationRoles.isEmpty() && m_TextRole.isEmpty())
+        return false;
+
+    // All roles changed
+    if (roles.isEmpty())
+        return true;
+
+    if (m_InvalidationDirty) {
+        m_lInvalidationIds.clear();
+
+        for (const auto& name : qAsConst(m_lInvalidationRoles)) {
+            const int id = roleIndex(name);
+            if (id != -1)
+                m_lInvalidationIds << id;
+        }
+
+        // The measured text obviously changes the size
+        const int textId = m_TextRole.isEmpty() ? -1 : roleIndex(m_TextRole);
+        if (textId != -1)
+            m_lInvalidationIds << textId;
+
+        m_InvalidationDirty = false;
+    }
+
+    for (int r : qAsConst(roles)) {
+        if (m_lInvalidationIds.contains(r))
+            return true;
+    }
+
+    return false;
+}
+
+/// The node of `parent` children, null if nothing is cached for them
+SizeHintProxyModelPrivate::CacheNode* SizeHintProxyModelPrivate::node(const QModelIndex& parent, bool create) const
+{
+    if (!parent.isValid())
+        return &m_Cache;
+
+    // The children are indexed by row, only the first column can have some
+    if (parent.column())
+        return nullptr;
+
+    const auto p = node(parent.parent(), create);
+
+    if (!p)
+        return nullptr;
+
+    if (parent.row() >= p->children.size()) {
+        if (!create)
+            return nullptr;
+
+        p->children.resize(parent.row() + 1);
+    }
+
+    auto& ret = p->children[parent.row()];
+
+    if ((!ret) && create)
+        ret = new CacheNode();
+
+    return ret;
+}
+
+bool SizeHintProxyModelPrivate::isCacheEmpty() const
+{
+    return m_Cache.rows.isEmpty() && m_Cache.children.isEmpty();
+}
+
+void SizeHintProxyModelPrivate::clearCache()
+{
+    qDeleteAll(m_Cache.children);
+    m_Cache.children.clear();
+    m_Cache.rows.clear();
+}
+
+/// Shift the entries of the rows after `first` to make room for `count` rows
+void SizeHintProxyModelPrivate::insertRows(CacheNode *n, int first, int count)
+{
+    if (!n)
+        return;
+
+    for (auto& rows : n->rows) {
+        if (first < rows.size())
+            rows.insert(first, count, {});
+    }
+
+    if (first < n->children.size())
+        n->children.insert(first, count, nullptr);
+}
+
+/**
+ * Drop the entries of `count` rows from `first` and those of their children.
+ *
+ * @param taken Keep the nodes of their children (`count` of them, null when
+ *  nothing is cached) rather than deleting them
+ */
+void SizeHintProxyModelPrivate::removeRows(CacheNode *n, int first, int count, CacheNode **taken)
+{
+    if (!n)
+        return;
+
+    for (auto& rows : n->rows) {
+        if (first < rows.size())
+            rows.remove(first, std::min(count, rows.size() - first));
+    }
+
+    if (first >= n->children.size())
+        return;
+
+    const int c = std::min(count, n->children.size() - first);
+
+    for (int i = 0; i < c; i++) {
+        if (taken)
+            taken[i] = n->children[first + i];
+        else
+            delete n->children[first + i];
+    }
+
+    n->children.remove(first, c);
 }
 
 void SizeHintProxyModelPrivate::slotDataChanged(const QModelIndex& tl, const QModelIndex& bl, const QVector<int>& roles)
 {
-    Q_UNUSED(tl)
-    Q_UNUSED(bl)
-    Q_UNUSED(roles)
-    //TODO check m_lInvalidationRoles and add a sync interface with the view
+    if (isCacheEmpty() || !isInvalidationRole(roles))
+        return;
+
+    const auto n = node(tl.parent());
+
+    if (!n)
+        return;
+
+    for (int c = tl.column(); c <= bl.column() && c < n->rows.size(); c++) {
+        for (int i = tl.row(); i <= bl.row() && i < n->rows[c].size(); i++) {
+            CachedSize& entry = n->rows[c][i];
+
+            // It was never measured, nothing depends on it yet
+            if (!entry.measured)
+                continue;
+
+            const QSizeF old = entry.size;
+            entry.measured   = false;
+
+            // `entry` is not used past this point, it may reallocate
+            const auto idx = q_ptr->index(i, c, tl.parent());
+
+            if (q_ptr->sizeHintForIndex(idx) != old)
+                Q_EMIT q_ptr->sizeHintChanged(idx);
+        }
+    }
+}
+
+void SizeHintProxyModelPrivate::slotRowsAboutToBeInserted(const QModelIndex& parent, int first, int last)
+{
+    insertRows(node(parent), first, last - first + 1);
+}
+
+void SizeHintProxyModelPrivate::slotRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    removeRows(node(parent), first, last - first + 1);
+}
+
+void SizeHintProxyModelPrivate::slotRowsAboutToBeMoved(const QModelIndex& parent, int start, int end,
+                                                       const QModelIndex& destination, int row)
+{
+    const int count = end - start + 1;
+
+    // Find the destination before its parent chain rows shift. It can't be
+    // one of the moved rows children.
+    const auto src = node(parent);
+    const auto dst = node(destination, src != nullptr);
+
+    // The moved rows are measured again, but the nodes of their children
+    // follow them.
+    QVector<CacheNode*> taken(count, nullptr);
+    removeRows(src, start, count, taken.data());
+
+    // `row` is relative to the rows before the move
+    const int first = (destination == parent && row > end) ? row - count : row;
+
+    if (!dst) {
+        qDeleteAll(taken);
+        return;
+    }
+
+    insertRows(dst, first, count);
+
+    if (std::any_of(taken.constBegin(), taken.constEnd(), [](CacheNode *n) { return n; })) {
+        if (dst->children.size() < first + count)
+            dst->children.resize(first + count);
+
+        std::copy(taken.constBegin(), taken.constEnd(), dst->children.begin() + first);
+    }
+}
+
+void SizeHintProxyModelPrivate::slotClear()
+{
+    clearCache();
 }
 
 void SizeHintProxyModelPrivate::reloadContext(QAbstractItemModel *m)
@@ -194,6 +462,8 @@ void SizeHintProxyModelPrivate::reloadContants()
         q_ptr->setProperty(i.key().toLatin1(), i.value());
     }
 
+    m_pQmlContext->setContextProperty(QStringLiteral("viewWidth"), m_ViewWidth);
+
     m_pHeightExpression = new QQmlExpression(
         m_HeightScript,
         m_pQmlContext,
@@ -215,7 +485,8 @@ qreal SizeHintProxyModelPrivate::evaluateForIndex(QQmlExpression* expr, const QM
 
     bool valueIsUndefined = false;
 
-    m_pContextAdapter->setModelIndex(idx);
+    // The expression reads the values directly, no need to notify
+    m_pContextAdapter->setModelIndex(idx, false);
     const QVariant var = expr->evaluate(&valueIsUndefined);//ret.toVariant();
 
     // There was an error in the expression
@@ -241,11 +512,253 @@ qreal SizeHintProxyModelPrivate::evaluateForIndex(QQmlExpression* expr, const QM
 
 QSizeF SizeHintProxyModel::sizeHintForIndex(const QModelIndex& idx)
 {
+    QSizeF cached;
+
+    if (d_ptr->lookup(idx, cached))
+        return cached;
+
+    // Read ahead, the next rows are very likely to be requested next
+    if (d_ptr->m_fRangeSizeHint && !idx.column()) {
+        static constexpr const int BLOCK_SIZE = 32;
+
+        const QModelIndex parent = idx.parent();
+        const int last = qMin(idx.row() + BLOCK_SIZE, rowCount(parent)) - 1;
+        QVarLengthArray<QSizeF, BLOCK_SIZE> buffer(last - idx.row() + 1);
+
+        sizeHintsForRows(parent, idx.row(), last, buffer.data());
+
+        return buffer[0];
+    }
+
+    // Native code doesn't need the context nor the expressions
+    if (d_ptr->m_fSizeHint) {
+        const QSizeF ret = d_ptr->m_fSizeHint(idx);
+        d_ptr->store(idx, ret);
+        return ret;
+    }
+
+    if (!d_ptr->m_TextRole.isEmpty()) {
+        // Without an explicit width, the text wraps at the view width
+        const qreal width = d_ptr->m_TextWidth > 0 ?
+            d_ptr->m_TextWidth : d_ptr->m_ViewWidth;
+
+        const QSizeF ret = TextMeasurer::measure(
+            idx.data(d_ptr->roleIndex(d_ptr->m_TextRole)).toString(),
+            d_ptr->m_TextFont,
+            width,
+            d_ptr->m_MaxLineCount
+        );
+        d_ptr->store(idx, ret);
+        return ret;
+    }
+
     const qreal w = d_ptr->m_pWidthExpression ?
         d_ptr->evaluateForIndex(d_ptr->m_pWidthExpression , idx) : 0;
     const qreal h = d_ptr->m_pHeightExpression ?
         d_ptr->evaluateForIndex(d_ptr->m_pHeightExpression, idx) : 0;
-    return QSizeF {w, h};
+
+    const QSizeF ret {w, h};
+
+    d_ptr->store(idx, ret);
+
+    return ret;
+}
+
+void SizeHintProxyModel::setSizeHintFunctor(const SizeHintFunctor& f)
+{
+    d_ptr->m_fSizeHint = f;
+    d_ptr->clearCache();
+}
+
+SizeHintProxyModel::SizeHintFunctor SizeHintProxyModel::sizeHintFunctor() const
+{
+    return d_ptr->m_fSizeHint;
+}
+
+void SizeHintProxyModel::setSizeHintRangeFunctor(const SizeHintRangeFunctor& f)
+{
+    d_ptr->m_fRangeSizeHint = f;
+    d_ptr->clearCache();
+}
+
+SizeHintProxyModel::SizeHintRangeFunctor SizeHintProxyModel::sizeHintRangeFunctor() const
+{
+    return d_ptr->m_fRangeSizeHint;
+}
+
+/// Call the range functor and cache the result
+void SizeHintProxyModelPrivate::fetchRange(const QModelIndex& parent, int first, int last, QSizeF* out)
+{
+    m_fRangeSizeHint(parent, first, last, out);
+
+    for (int i = first; i <= last; i++)
+        store(q_ptr->index(i, 0, parent), out[i - first]);
+}
+
+bool SizeHintProxyModelPrivate::lookup(const QModelIndex& idx, QSizeF& out) const
+{
+    const auto n = node(idx.parent());
+
+    if ((!n) || idx.column() >= n->rows.size())
+        return false;
+
+    const auto& rows = n->rows[idx.column()];
+
+    if (idx.row() >= rows.size())
+        return false;
+
+    const CachedSize& entry = rows[idx.row()];
+
+    if ((!entry.measured) || entry.bucket != m_Bucket)
+        return false;
+
+    out = entry.size;
+
+    return true;
+}
+
+void SizeHintProxyModelPrivate::store(const QModelIndex& idx, const QSizeF& size)
+{
+    const auto n = node(idx.parent(), true);
+
+    if (!n)
+        return;
+
+    auto& columns = n->rows;
+
+    if (idx.column() >= columns.size())
+        columns.resize(idx.column() + 1);
+
+    auto& rows = columns[idx.column()];
+
+    if (idx.row() >= rows.size())
+        rows.resize(idx.row() + 1);
+
+    rows[idx.row()] = {size, m_Bucket, true};
+}
+
+void SizeHintProxyModel::sizeHintsForRows(const QModelIndex& parent, int first, int last, QSizeF* out)
+{
+    if (last < first)
+        return;
+
+    if (!d_ptr->m_fRangeSizeHint) {
+        for (int i = first; i <= last; i++)
+            out[i - first] = sizeHintForIndex(index(i, 0, parent));
+
+        return;
+    }
+
+    // After a reset, nothing is cached and this is a single call
+    if (d_ptr->isCacheEmpty()) {
+        d_ptr->fetchRange(parent, first, last, out);
+        return;
+    }
+
+    // Only compute the contiguous runs of uncached rows
+    int runStart = -1;
+
+    for (int i = first; i <= last; i++) {
+        if (!d_ptr->lookup(index(i, 0, parent), out[i - first])) {
+            if (runStart == -1)
+                runStart = i;
+
+            continue;
+        }
+
+        if (runStart != -1) {
+            d_ptr->fetchRange(parent, runStart, i - 1, out + (runStart - first));
+            runStart = -1;
+        }
+    }
+
+    if (runStart != -1)
+        d_ptr->fetchRange(parent, runStart, last, out + (runStart - first));
+}
+
+qreal SizeHintProxyModel::viewWidth() const
+{
+    return d_ptr->m_ViewWidth;
+}
+
+void SizeHintProxyModel::setViewWidth(qreal width)
+{
+    d_ptr->m_ViewWidth = width;
+
+    // Moving within the same bucket keeps all the sizes
+    const int bucket = d_ptr->m_BucketSize > 0 ?
+        int(width / d_ptr->m_BucketSize) : int(width);
+
+    if (bucket == d_ptr->m_Bucket)
+        return;
+
+    d_ptr->m_Bucket = bucket;
+
+    if (d_ptr->m_pQmlContext)
+        d_ptr->m_pQmlContext->setContextProperty(QStringLiteral("viewWidth"), width);
+}
+
+qreal SizeHintProxyModel::widthBucketSize() const
+{
+    return d_ptr->m_BucketSize;
+}
+
+void SizeHintProxyModel::setWidthBucketSize(qreal size)
+{
+    d_ptr->m_BucketSize = size;
+    d_ptr->m_Bucket     = size > 0 ?
+        int(d_ptr->m_ViewWidth / size) : int(d_ptr->m_ViewWidth);
+    d_ptr->clearCache();
+}
+
+int SizeHintProxyModel::widthBucket() const
+{
+    return d_ptr->m_Bucket;
+}
+
+QString SizeHintProxyModel::textRole() const
+{
+    return d_ptr->m_TextRole;
+}
+
+void SizeHintProxyModel::setTextRole(const QString& role)
+{
+    d_ptr->m_TextRole = role;
+    d_ptr->m_InvalidationDirty = true;
+    d_ptr->clearCache();
+}
+
+QFont SizeHintProxyModel::textFont() const
+{
+    return d_ptr->m_TextFont;
+}
+
+void SizeHintProxyModel::setTextFont(const QFont& font)
+{
+    d_ptr->m_TextFont = font;
+    d_ptr->clearCache();
+}
+
+qreal SizeHintProxyModel::textWidth() const
+{
+    return d_ptr->m_TextWidth;
+}
+
+void SizeHintProxyModel::setTextWidth(qreal width)
+{
+    d_ptr->m_TextWidth = width;
+    d_ptr->clearCache();
+}
+
+int SizeHintProxyModel::maximumLineCount() const
+{
+    return d_ptr->m_MaxLineCount;
+}
+
+void SizeHintProxyModel::setMaximumLineCount(int count)
+{
+    d_ptr->m_MaxLineCount = count;
+    d_ptr->clearCache();
 }
 
 QQmlScriptString SizeHintProxyModel::widthHint() const
@@ -261,6 +774,7 @@ void SizeHintProxyModel::setWidthHint(const QQmlScriptString& value)
     }
     d_ptr->m_WidthScript = value;
     d_ptr->m_ReloadContants = true;
+    d_ptr->clearCache();
 }
 
 QQmlScriptString SizeHintProxyModel::heightHint() const
@@ -277,5 +791,6 @@ void SizeHintProxyModel::setHeightHint(const QQmlScriptString& value)
 
     d_ptr->m_HeightScript = value;
     d_ptr->m_ReloadContants = true;
+    d_ptr->clearCache();
 }
 
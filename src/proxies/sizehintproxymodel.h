@@ -20,9 +20,13 @@
 // Qt
 #include <QtCore/QIdentityProxyModel>
 #include <QtCore/QVariant>
+#include <QtGui/QFont>
 #include <QJSValue>
 #include <QQmlScriptString>
 
+// LibStdC++
+#include <functional>
+
 class SizeHintProxyModelPrivate;
 
 /**
@@ -42,8 +46,9 @@ class SizeHintProxyModelPrivate;
  * public APIs. That being said, it should usually be possible to gather the
  * data in one way or another.
  *
- * This class is part of the public C++ API so the `sizeHint` method can be
- * re-implemented. Otherwise it is specified in JavaScript.
+ * This class is part of the public C++ API so the size hint can be computed
+ * by native code using `setSizeHintFunctor`. Otherwise it is specified in
+ * JavaScript.
  */
 class Q_DECL_EXPORT SizeHintProxyModel : public QIdentityProxyModel
 {
@@ -79,12 +84,53 @@ public:
      * matching the entries in this list, assume the size hint needs to be
      * recomputed.
      *
+     * The size hints are otherwise cached for each row (for performance).
      * When used with the other KQuickView views, they will be notified.
      *
      * Note that the constants wont be invalidated.
      */
     Q_PROPERTY(QStringList invalidationRoles READ invalidationRoles WRITE setInvalidationRoles)
 
+    /**
+     * Measure the text of this role rather than evaluating the expressions.
+     *
+     * Most variable height rows are wrapped text. This measures them
+     * exactly using `textFont`, `textWidth` and `maximumLineCount` without
+     * involving a delegate nor the JavaScript engine (for performance). The
+     * results are shared across all proxies.
+     */
+    Q_PROPERTY(QString textRole READ textRole WRITE setTextRole)
+
+    /// The font used to measure the `textRole`
+    Q_PROPERTY(QFont textFont READ textFont WRITE setTextFont)
+
+    /// The width at which the `textRole` wraps, 0 to wrap at the `viewWidth`
+    Q_PROPERTY(qreal textWidth READ textWidth WRITE setTextWidth)
+
+    /// The maximum number of lines of the `textRole`, 0 for no limit
+    Q_PROPERTY(int maximumLineCount READ maximumLineCount WRITE setMaximumLineCount)
+
+    /**
+     * The width of the view, it is set by the views using this proxy.
+     *
+     * It is also exposed to the expressions as `viewWidth`. Only changes
+     * crossing a `widthBucketSize` boundary invalidate the cached sizes and
+     * the rows are then measured again only when they are requested. Height
+     * changes don't affect the sizes at all (for performance).
+     */
+    Q_PROPERTY(qreal viewWidth READ viewWidth WRITE setViewWidth)
+
+    /// The view width granularity at which the sizes are measured again
+    Q_PROPERTY(qreal widthBucketSize READ widthBucketSize WRITE setWidthBucketSize)
+
+    /// Compute the size of an index without the JavaScript engine
+    using SizeHintFunctor = std::function<QSizeF(const QModelIndex& index)>;
+
+    /// Compute the sizes of the rows `first` to `last` into `out`
+    using SizeHintRangeFunctor = std::function<void(
+        const QModelIndex& parent, int first, int last, QSizeF* out
+    )>;
+
     explicit SizeHintProxyModel(QObject* parent = nullptr);
     virtual ~SizeHintProxyModel();
 
@@ -102,8 +148,56 @@ public:
     QStringList invalidationRoles() const;
     void setInvalidationRoles(const QStringList& l);
 
+    QString textRole() const;
+    void setTextRole(const QString& role);
+
+    QFont textFont() const;
+    void setTextFont(const QFont& font);
+
+    qreal textWidth() const;
+    void setTextWidth(qreal width);
+
+    int maximumLineCount() const;
+    void setMaximumLineCount(int count);
+
+    qreal viewWidth() const;
+    void setViewWidth(qreal width);
+
+    qreal widthBucketSize() const;
+    void setWidthBucketSize(qreal size);
+
+    /// The index of the `widthBucketSize` interval the `viewWidth` is in
+    int widthBucket() const;
+
+    /**
+     * Use a C++ function rather than the `widthHint` and `heightHint`
+     * expressions (for performance).
+     *
+     * The index belongs to this proxy. The result is cached like the ones
+     * of the expressions. Set an empty functor to use the expressions again.
+     */
+    void setSizeHintFunctor(const SizeHintFunctor& f);
+    SizeHintFunctor sizeHintFunctor() const;
+
+    /**
+     * Compute whole blocks of rows at once (for performance).
+     *
+     * This is used before the per index functor and the expressions. It
+     * allows the sizes to be computed from column oriented data (such as
+     * `MultiRoleModel`) in a tight loop rather than one index at a time.
+     * When set, a cache miss also computes the next uncached rows.
+     */
+    void setSizeHintRangeFunctor(const SizeHintRangeFunctor& f);
+    SizeHintRangeFunctor sizeHintRangeFunctor() const;
+
     Q_INVOKABLE QSizeF sizeHintForIndex(const QModelIndex& idx);
 
+    /**
+     * Write the size hints of the rows `first` to `last` (inclusive) of
+     * `parent` into `out`, which must hold `last - first + 1` elements.
+     */
+    void sizeHintsForRows(const QModelIndex& parent, int first, int last, QSizeF* out);
+
     Q_INVOKABLE QVariant getRoleValue(const QModelIndex& idx, const QString& roleName) const;
 
 public Q_SLOTS:
@@ -112,6 +206,13 @@ public Q_SLOTS:
      */
     void invalidateConstants();
 
+Q_SIGNALS:
+    /**
+     * The size hint of a previously measured index changed because one of
+     * the `invalidationRoles` changed.
+     */
+    void sizeHintChanged(const QModelIndex& index);
+
 private:
     SizeHintProxyModelPrivate* d_ptr;
     Q_DECLARE_PRIVATE(SizeHintProxyModel)
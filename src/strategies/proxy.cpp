@@ -19,15 +19,104 @@
 
 #include <proxies/sizehintproxymodel.h>
 #include <viewport.h>
+#include <private/viewport_p.h>
+#include <private/statetracker/content_p.h>
 #include <adapters/modeladapter.h>
 
-GeometryStrategies::Proxy::Proxy(Viewport *parent) : GeometryAdapter(parent)
+class ProxyStrategiesPrivate
 {
+public:
+    QMetaObject::Connection m_Conn;
+
+    void setModel(QAbstractItemModel *m);
+    void slotWidthChanged(qreal width);
+
+    GeometryStrategies::Proxy *q_ptr;
+};
+
+GeometryStrategies::Proxy::Proxy(Viewport *parent) : GeometryAdapter(parent),
+    d_ptr(new ProxyStrategiesPrivate())
+{
+    d_ptr->q_ptr = this;
     setCapabilities(Capabilities::HAS_AHEAD_OF_TIME);
+
+    if (!parent)
+        return;
+
+    d_ptr->setModel(parent->modelAdapter()->rawModel());
+
+    connect(parent->modelAdapter(), &ModelAdapter::modelChanged, this,
+        [this](QAbstractItemModel *m) { d_ptr->setModel(m); });
+
+    connect(parent, &Viewport::widthChanged, this,
+        [this](qreal w) { d_ptr->slotWidthChanged(w); });
 }
 
 GeometryStrategies::Proxy::~Proxy()
-{}
+{
+    QObject::disconnect(d_ptr->m_Conn);
+    delete d_ptr;
+}
+
+/// Only update the geometry of the loaded rows which really changed size
+void ProxyStrategiesPrivate::setModel(QAbstractItemModel *m)
+{
+    QObject::disconnect(m_Conn);
+
+    auto p = qobject_cast<SizeHintProxyModel*>(m);
+
+    if (!p)
+        return;
+
+    p->setViewWidth(q_ptr->viewport()->size().width());
+
+    m_Conn = QObject::connect(p, &SizeHintProxyModel::sizeHintChanged, q_ptr,
+        [this](const QModelIndex& idx) {
+            const auto s = q_ptr->viewport()->s_ptr;
+
+            if (auto md = s->metadataForIndex(idx)) {
+                s->notifyChange(md);
+                s->updateGeometry(md);
+            }
+    });
+}
+
+/// Measure the visible rows again, the others are measured when needed
+void ProxyStrategiesPrivate::slotWidthChanged(qreal width)
+{
+    auto p = qobject_cast<SizeHintProxyModel*>(
+        q_ptr->viewport()->modelAdapter()->rawModel()
+    );
+
+    if (!p)
+        return;
+
+    const int bucket = p->widthBucket();
+    p->setViewWidth(width);
+
+    if (p->widthBucket() == bucket)
+        return;
+
+    const auto s = q_ptr->viewport()->s_ptr;
+
+    auto md  = s->m_pReflector->getEdge(IndexMetadata::EdgeType::VISIBLE, Qt::TopEdge   );
+    auto bve = s->m_pReflector->getEdge(IndexMetadata::EdgeType::VISIBLE, Qt::BottomEdge);
+
+    // Updating the geometry may change the edges, collect them first
+    QVector<IndexMetadata*> visible;
+
+    for (; md; md = md->down()) {
+        visible << md;
+
+        if (md == bve)
+            break;
+    }
+
+    for (auto i : qAsConst(visible)) {
+        s->notifyChange(i);
+        s->updateGeometry(i);
+    }
+}
 
 QSizeF GeometryStrategies::Proxy::sizeHint(const QModelIndex &index, AbstractItemAdapter *adapter) const
 {
@@ -18,6 +18,7 @@
 #pragma once
 
 class Viewport;
+class ProxyStrategiesPrivate;
 #include <adapters/geometryadapter.h>
 
 namespace GeometryStrategies
@@ -34,6 +35,9 @@ public:
     virtual ~Proxy();
 
     Q_INVOKABLE virtual QSizeF sizeHint(const QModelIndex &index, AbstractItemAdapter *adapter) const override;
+
+private:
+    ProxyStrategiesPrivate *d_ptr;
 };
 
 }
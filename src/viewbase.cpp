@@ -19,13 +19,17 @@
 
 // Qt
 #include <QtCore/QTimer>
+#include <QtCore/QPointer>
 #include <QQmlContext>
 
 // LibStdC++
 #include <functional>
+#include <algorithm>
 
 // KQuickItemViews
 #include "private/statetracker/viewitem_p.h"
+#include "private/viewbase_p.h"
+#include "private/framescheduler_p.h"
 #include "adapters/abstractitemadapter.h"
 #include "adapters/selectionadapter.h"
 #include "private/statetracker/content_p.h"
@@ -69,6 +73,14 @@ public:
 
     State m_State {State::UNFILLED};
 
+    // Deferred destruction
+    QVector<QPointer<QObject>> m_lGraveyard;
+    bool m_GraveyardScheduled  {false};
+    int  m_DestructionBatchSize{  0  };
+    bool m_ScrollAnchoring     {false};
+
+    FrameScheduler *m_pScheduler {nullptr};
+
     ViewBase* q_ptr;
 
 private:
@@ -81,6 +93,7 @@ private:
 
 public Q_SLOTS:
     void slotContentChanged();
+    void slotEmptyGraveyard();
 };
 
 /// Add the same property as the QtQuick.ListView
@@ -90,6 +103,7 @@ public:
     virtual ~ModelIndexGroup() {}
     virtual QVector<QByteArray>& propertyNames() const override;
     virtual QVariant getProperty(AbstractItemAdapter* item, uint id, const QModelIndex& index) const override;
+    virtual int structuralDependencies(uint id) const override;
 };
 
 #define S ViewBasePrivate::State::
@@ -114,13 +128,19 @@ const ViewBasePrivate::StateF ViewBasePrivate::m_fStateMachine[5][5] = {
 };
 #undef A
 
-ViewBase::ViewBase(QQuickItem* parent) : Flickable(parent), d_ptr(new ViewBasePrivate())
+ViewBase::ViewBase(QQuickItem* parent) : Flickable(parent),
+    s_ptr(new ViewBaseSync()), d_ptr(new ViewBasePrivate())
 {
     d_ptr->q_ptr = this;
+    s_ptr->q_ptr = this;
 }
 
 ViewBase::~ViewBase()
 {
+    s_ptr->emptyGraveyard();
+
+    delete d_ptr->m_pScheduler;
+    delete s_ptr;
     delete d_ptr;
 }
 
@@ -149,6 +169,65 @@ void ViewBasePrivate::slotContentChanged()
     emit q_ptr->contentChanged();
 }
 
+void ViewBaseSync::bury(QObject *o)
+{
+    auto d = q_ptr->d_ptr;
+
+    d->m_lGraveyard << o;
+
+    // Only a single event is posted no matter how many objects are queued
+    if (!d->m_GraveyardScheduled) {
+        d->m_GraveyardScheduled = true;
+        QTimer::singleShot(0, d, &ViewBasePrivate::slotEmptyGraveyard);
+    }
+}
+
+void ViewBaseSync::emptyGraveyard()
+{
+    auto d = q_ptr->d_ptr;
+
+    // The destructors are allowed to bury more objects
+    while (!d->m_lGraveyard.isEmpty()) {
+        const auto batch = d->m_lGraveyard;
+        d->m_lGraveyard.clear();
+
+        for (const auto &o : qAsConst(batch))
+            delete o.data();
+    }
+}
+
+FrameScheduler *ViewBaseSync::scheduler() const
+{
+    auto d = q_ptr->d_ptr;
+
+    if (!d->m_pScheduler)
+        d->m_pScheduler = new FrameScheduler(q_ptr);
+
+    return d->m_pScheduler;
+}
+
+void ViewBasePrivate::slotEmptyGraveyard()
+{
+    m_GraveyardScheduled = false;
+
+    const int count = m_DestructionBatchSize > 0 ?
+        std::min(m_DestructionBatchSize, m_lGraveyard.size()) : m_lGraveyard.size();
+
+    // Detach the batch first, the destructors are allowed to bury more objects
+    const auto batch = m_lGraveyard.mid(0, count);
+    m_lGraveyard.remove(0, count);
+
+    // QtQuick may already have destroyed some of them, QPointer handles it
+    for (const auto &o : qAsConst(batch))
+        delete o.data();
+
+    // Spread the remaining objects over the next iterations to avoid a hitch
+    if ((!m_lGraveyard.isEmpty()) && !m_GraveyardScheduled) {
+        m_GraveyardScheduled = true;
+        QTimer::singleShot(0, this, &ViewBasePrivate::slotEmptyGraveyard);
+    }
+}
+
 bool ViewBasePrivate::nothing()
 { return true; }
 
@@ -212,6 +291,19 @@ QVariant ModelIndexGroup::getProperty(AbstractItemAdapter* item, uint id, const
     return {};
 }
 
+int ModelIndexGroup::structuralDependencies(uint id) const
+{
+    switch(id) {
+        case 0 /*index*/:
+            return StructureFlags::ROW;
+        case 2 /*rowCount*/:
+            return StructureFlags::CHILDREN;
+    }
+
+    // The QPersistentModelIndex follows the changes by itself
+    return StructureFlags::NONE;
+}
+
 void ViewBase::addModelAdapter(ModelAdapter* a)
 {
     connect(a, &ModelAdapter::contentChanged,
@@ -254,4 +346,36 @@ void ViewBase::setGravity(Qt::Corner g)
     refresh();
 }
 
+int ViewBase::destructionBatchSize() const
+{
+    return d_ptr->m_DestructionBatchSize;
+}
+
+void ViewBase::setDestructionBatchSize(int size)
+{
+    d_ptr->m_DestructionBatchSize = std::max(0, size);
+}
+
+int ViewBase::frameBudget() const
+{
+    // Don't create the scheduler just to read the default
+    return d_ptr->m_pScheduler ?
+        d_ptr->m_pScheduler->budget() : FrameScheduler::DEFAULT_BUDGET;
+}
+
+void ViewBase::setFrameBudget(int ms)
+{
+    s_ptr->scheduler()->setBudget(ms);
+}
+
+bool ViewBase::hasScrollAnchoring() const
+{
+    return d_ptr->m_ScrollAnchoring;
+}
+
+void ViewBase::setScrollAnchoring(bool v)
+{
+    d_ptr->m_ScrollAnchoring = v;
+}
+
 #include <viewbase.moc>
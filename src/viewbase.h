@@ -26,6 +26,7 @@ class QQmlComponent;
 
 // KQuickItemViews
 class ViewBasePrivate;
+class ViewBaseSync;
 class AbstractItemAdapter;
 class ModelAdapter;
 class Viewport;
@@ -47,6 +48,8 @@ class Viewport;
  */
 class Q_DECL_EXPORT ViewBase : public Flickable
 {
+    friend class ViewBaseSync; // its own internal API
+
     Q_OBJECT
 public:
     struct ItemFactoryBase {
@@ -62,10 +65,32 @@ public:
 
     Q_PROPERTY(bool empty READ isEmpty NOTIFY contentChanged)
     Q_PROPERTY(Qt::Corner gravity READ gravity WRITE setGravity)
+    /// The maximum number of delegates freed per event loop iteration, 0 for no limit (for latency)
+    Q_PROPERTY(int destructionBatchSize READ destructionBatchSize WRITE setDestructionBatchSize)
+    /// The time (in ms, 5 by default) spent per frame on the model changes and offscreen delegates, 0 to apply them immediately (for latency)
+    Q_PROPERTY(int frameBudget READ frameBudget WRITE setFrameBudget)
+    /**
+     * Keep the row at the top of the viewport in place when the rows above it
+     * are inserted, removed or resized, like CSS scroll anchoring.
+     *
+     * The contentY is compensated in a single step once per frame. Nothing is
+     * anchored when the view is scrolled to the top, so live feeds still
+     * show the new rows there.
+     */
+    Q_PROPERTY(bool scrollAnchoring READ hasScrollAnchoring WRITE setScrollAnchoring)
 
     Qt::Corner gravity() const;
     void setGravity(Qt::Corner g);
 
+    int destructionBatchSize() const;
+    void setDestructionBatchSize(int size);
+
+    int frameBudget() const;
+    void setFrameBudget(int ms);
+
+    bool hasScrollAnchoring() const;
+    void setScrollAnchoring(bool v);
+
     explicit ViewBase(QQuickItem* parent = nullptr);
 
     virtual ~ViewBase();
@@ -74,6 +99,8 @@ public:
 
     bool isEmpty() const;
 
+    ViewBaseSync *s_ptr;
+
 protected:
     virtual void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
 
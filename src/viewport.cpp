@@ -21,6 +21,7 @@
 #include <QtCore/QDebug>
 #include <QQmlEngine>
 #include <QQmlContext>
+#include <QQuickItem>
 
 // KQuickItemViews
 #include "private/viewport_p.h"
@@ -36,6 +37,10 @@
 #include "viewbase.h"
 #include "private/indexmetadata_p.h"
 #include "private/geostrategyselector_p.h"
+#include "private/delegatepool_p.h"
+#include "private/framescheduler_p.h"
+#include "private/viewbase_p.h"
+#include "private/componentcache_p.h"
 
 class ViewportPrivate : public QObject
 {
@@ -49,7 +54,17 @@ public:
     QRectF m_ViewRect;
     QRectF m_UsedRect;
 
+    // The row kept in place by ViewBase::scrollAnchoring
+    QPersistentModelIndex m_AnchorIndex;
+    qreal                 m_AnchorOffset {0};
+
     void updateAvailableEdges();
+    void applyMove();
+    bool isFarJump() const;
+    QModelIndex rowAt(qreal y, qreal &top) const;
+    void recordAnchor();
+    void scheduleAnchor();
+    void restoreAnchor();
 
     Viewport *q_ptr;
 
@@ -57,6 +72,7 @@ public Q_SLOTS:
     void slotModelChanged(QAbstractItemModel* m, QAbstractItemModel* o);
     void slotModelAboutToChange(QAbstractItemModel* m, QAbstractItemModel* o);
     void slotViewportChanged(const QRectF &viewport);
+    void slotFlickEndChanged(qreal y);
 };
 
 Viewport::Viewport(ModelAdapter* ma) : QObject(),
@@ -67,6 +83,7 @@ Viewport::Viewport(ModelAdapter* ma) : QObject(),
     d_ptr->m_pModelAdapter = ma;
     s_ptr->m_pReflector    = new StateTracker::Content(this);
     s_ptr->m_pGeoAdapter   = new GeoStrategySelector(this);
+    s_ptr->m_pPool         = new DelegatePool(this);
 
     resize(QRectF { 0.0, 0.0, ma->view()->width(), ma->view()->height() });
 
@@ -74,6 +91,8 @@ Viewport::Viewport(ModelAdapter* ma) : QObject(),
         d_ptr, &ViewportPrivate::slotModelChanged);
     connect(ma->view(), &Flickable::viewportChanged,
         d_ptr, &ViewportPrivate::slotViewportChanged);
+    connect(ma->view(), &Flickable::flickEndYChanged,
+        d_ptr, &ViewportPrivate::slotFlickEndChanged);
     connect(ma, &ModelAdapter::delegateChanged, s_ptr->m_pReflector, [this]() {
         s_ptr->m_pReflector->modelTracker()->performAction(
             StateTracker::Model::Action::RESET
@@ -128,8 +147,214 @@ void ViewportPrivate::slotViewportChanged(const QRectF &viewport)
 //     Q_ASSERT(viewport.y() == 0); //FIXME I broke it
     m_ViewRect = viewport;
     m_UsedRect = viewport; //FIXME remove wrong
+
+    // Wheel and touch events can move the viewport many times per frame,
+    // only load the content for the latest position. The Flickable inertia
+    // is connected to the frames first, so it doesn't add a frame of delay.
+    m_pModelAdapter->view()->s_ptr->scheduler()->scheduleOnce(
+        this, [this]() { applyMove(); }
+    );
+}
+
+/**
+ * Measure the rows up to where the flick stops when the pointer is released.
+ *
+ * The inertia frames then only read the cached size hints rather than
+ * evaluating them for each row they uncover (for latency).
+ */
+void ViewportPrivate::slotFlickEndChanged(qreal y)
+{
+    const auto caps = q_ptr->s_ptr->m_pGeoAdapter->capabilities();
+
+    if (!(caps & GeometryAdapter::Capabilities::HAS_AHEAD_OF_TIME))
+        return;
+
+    qreal top = 0.0;
+    rowAt(y + m_ViewRect.height(), top);
+}
+
+/// If the viewport is further than one page away from the loaded rows
+bool ViewportPrivate::isFarJump() const
+{
+    // Without the geometry ahead of time, the destination isn't known until
+    // the delegates on the way are loaded.
+    const auto caps = q_ptr->s_ptr->m_pGeoAdapter->capabilities();
+
+    if (!(caps & GeometryAdapter::Capabilities::HAS_AHEAD_OF_TIME))
+        return false;
+
+    const auto r = q_ptr->s_ptr->m_pReflector;
+
+    auto tve = r->getEdge(IndexMetadata::EdgeType::VISIBLE, Qt::TopEdge   );
+    auto bve = r->getEdge(IndexMetadata::EdgeType::VISIBLE, Qt::BottomEdge);
+
+    if ((!tve) || (!bve) || (!tve->isValid()) || !bve->isValid())
+        return false;
+
+    const qreal top    = tve->decoratedGeometry().top() - m_ViewRect.height();
+    const qreal bottom = bve->decoratedGeometry().bottom() + m_ViewRect.height();
+
+    return m_ViewRect.bottom() < top || m_ViewRect.top() > bottom;
+}
+
+/**
+ * Find the top level row at `y` using the ahead of time geometry.
+ *
+ * It starts from the loaded rows and only reads the size hints, no delegate
+ * or metadata is created for the rows on the way.
+ *
+ * @param top The position of the row
+ * @return An invalid index if the rows have children (their height depends on
+ *  what is expanded)
+ */
+QModelIndex ViewportPrivate::rowAt(qreal y, qreal &top) const
+{
+    const auto s = q_ptr->s_ptr;
+    const auto m = m_pModelAdapter->rawModel();
+
+    if ((!m) || !m->rowCount())
+        return {};
+
+    int row = 0;
+    top     = 0.0;
+
+    auto tve = s->m_pReflector->getEdge(IndexMetadata::EdgeType::VISIBLE, Qt::TopEdge);
+
+    if (tve && tve->isValid() && !tve->index().parent().isValid()) {
+        row = tve->index().row();
+        top = tve->decoratedGeometry().top();
+    }
+
+    auto height = [s, m](int r) -> qreal {
+        const auto idx = m->index(r, 0);
+
+        return m->hasChildren(idx) ?
+            -1 : s->m_pGeoAdapter->sizeHint(idx, nullptr).height();
+    };
+
+    for (; row > 0 && top > y; row--) {
+        const qreal h = height(row - 1);
+
+        if (h < 0)
+            return {};
+
+        top -= h;
+    }
+
+    for (const int rc = m->rowCount(); row < rc - 1; row++) {
+        const qreal h = height(row);
+
+        if (h < 0)
+            return {};
+
+        if (top + h > y)
+            break;
+
+        top += h;
+    }
+
+    return m->index(row, 0);
+}
+
+void ViewportPrivate::applyMove()
+{
+    const auto s = q_ptr->s_ptr;
+
+    // Rather than loading all the rows on the way, forget the loaded ones
+    // and load the destination first. The rows above it are only loaded if
+    // the view scrolls back to them.
+    if (isFarJump()) {
+        qreal top = 0.0;
+        const auto idx = rowAt(m_ViewRect.top(), top);
+
+        if (idx.isValid())
+            s->m_pReflector->relocate(idx, top);
+    }
+
     updateAvailableEdges();
-    q_ptr->s_ptr->m_pReflector->modelTracker() << StateTracker::Model::Action::MOVE;
+    s->m_pReflector->modelTracker() << StateTracker::Model::Action::MOVE;
+
+    s->restoreEvicted();
+
+    recordAnchor();
+}
+
+/// Remember the first row starting in the viewport and where it is
+void ViewportPrivate::recordAnchor()
+{
+    m_AnchorIndex = {};
+
+    const auto view = m_pModelAdapter->view();
+
+    if ((!view->hasScrollAnchoring()) || view->currentY() <= 0)
+        return;
+
+    const qreal y = view->currentY();
+
+    IndexMetadata *anchor = nullptr;
+
+    auto md = q_ptr->s_ptr->m_pReflector->getEdge(
+        IndexMetadata::EdgeType::VISIBLE, Qt::TopEdge
+    );
+
+    for (; md && md->isValid(); md = md->down()) {
+        const QRectF geo = md->decoratedGeometry();
+
+        if (geo.top() > m_ViewRect.bottom())
+            break;
+
+        // Fallback on the partially visible row when it fills the viewport
+        if (!anchor)
+            anchor = md;
+
+        if (geo.top() >= y) {
+            anchor = md;
+            break;
+        }
+    }
+
+    if (!anchor)
+        return;
+
+    m_AnchorIndex  = anchor->index();
+    m_AnchorOffset = anchor->decoratedGeometry().top() - y;
+}
+
+/// Wait until all the geometry changes of the frame are applied
+void ViewportPrivate::scheduleAnchor()
+{
+    if (!m_AnchorIndex.isValid())
+        return;
+
+    m_pModelAdapter->view()->s_ptr->scheduler()->scheduleOnce(
+        q_ptr, [this]() { restoreAnchor(); },
+        FrameScheduler::Phase::AFTER_ACTIONS
+    );
+}
+
+void ViewportPrivate::restoreAnchor()
+{
+    const auto view = m_pModelAdapter->view();
+    const auto md   = m_AnchorIndex.isValid() ?
+        q_ptr->s_ptr->metadataForIndex(m_AnchorIndex) : nullptr;
+
+    // Scroll by the size delta above the anchor in one step
+    if (md && md->isValid() && view->hasScrollAnchoring()) {
+        const qreal delta = md->decoratedGeometry().top()
+            - m_AnchorOffset - view->currentY();
+
+        if (!qFuzzyIsNull(delta)) {
+            view->setCurrentY(view->currentY() + delta);
+
+            // Don't wait for the next frame to load the uncovered rows. The
+            // move `setCurrentY` queued would then load them a second time.
+            view->s_ptr->scheduler()->cancelOnce(this);
+            applyMove();
+            return;
+        }
+    }
+
+    recordAnchor();
 }
 
 ModelAdapter *Viewport::modelAdapter() const
@@ -291,6 +516,8 @@ void ViewportSync::geometryUpdated(IndexMetadata *item)
 
 void ViewportSync::updateGeometry(IndexMetadata* item)
 {
+    q_ptr->d_ptr->scheduleAnchor();
+
     if (m_pGeoAdapter->capabilities() & GeometryAdapter::Capabilities::TRACKS_QQUICKITEM_GEOMETRY)
         item->sizeHint();
 
@@ -313,6 +540,8 @@ void ViewportSync::notifyChange(IndexMetadata* item)
 void ViewportSync::notifyRemoval(IndexMetadata* item)
 {
     Q_UNUSED(item)
+    q_ptr->d_ptr->scheduleAnchor();
+
     if (m_pReflector->modelTracker()->state() == StateTracker::Model::State::RESETING)
         return; //TODO it needs another state machine to get rid of the `if`
 
@@ -393,7 +622,7 @@ void ViewportSync::refreshVisible()
                 i->decoratedGeometry();
         }
         else
-            prev->setPosition({0.0, 0.0});
+            prev->setPosition(originOf(prev));
     }
 
     const bool hasSingleItem = item == bve;
@@ -428,6 +657,8 @@ void ViewportSync::notifyInsert(IndexMetadata* item)
     using GeoState = StateTracker::Geometry::State;
     Q_ASSERT(item);
 
+    q_ptr->d_ptr->scheduleAnchor();
+
     if (m_pReflector->modelTracker()->state() == StateTracker::Model::State::RESETING)
         return; //TODO it needs another state machine to get rid of the `if`
 
@@ -445,7 +676,7 @@ void ViewportSync::notifyInsert(IndexMetadata* item)
 
     // If the item is inserted in front, set the position
     if (item->isTopItem()) {
-        item->setPosition({0.0, 0.0});
+        item->setPosition(originOf(item));
     }
 
     auto bve = m_pReflector->getEdge(
@@ -478,6 +709,7 @@ void Viewport::resize(const QRectF& rect)
         return; //TODO it needs another state machine to get rid of the `if`
 
     const bool wasValid = d_ptr->m_ViewRect.size().isValid();
+    const bool widthChanged = d_ptr->m_ViewRect.width() != rect.width();
 
     Q_ASSERT(rect.x() == 0);
 
@@ -490,6 +722,10 @@ void Viewport::resize(const QRectF& rect)
     // anything. This could eventually change
     d_ptr->m_UsedRect.setSize(rect.size()); //FIXME remove, wrong
 
+    // Let the size hints be updated before the visible items are refreshed
+    if (widthChanged)
+        Q_EMIT this->widthChanged(rect.width());
+
     s_ptr->refreshVisible();
 
     d_ptr->updateAvailableEdges();
@@ -520,12 +756,236 @@ QQmlEngine *ViewportSync::engine()
 
 QQmlComponent *ViewportSync::component()
 {
-    engine();
+    return ComponentCache::get(
+        engine(), "import QtQuick 2.4; Item {property QtObject content: null;}"
+    );
+}
+
+void ViewportSync::notifyLoaded(StateTracker::ViewItem *item)
+{
+    m_lEvicted.remove(item);
+
+    if (item->m_IsLive) {
+        touch(item);
+        return;
+    }
+
+    item->m_IsLive        = true;
+    item->m_pPreviousLive = m_pLastLive;
+    item->m_pNextLive     = nullptr;
+
+    if (m_pLastLive)
+        m_pLastLive->m_pNextLive = item;
+    else
+        m_pFirstLive = item;
+
+    m_pLastLive = item;
+    m_LiveCount++;
+
+    enforceDelegateBudget();
+
+    Q_EMIT q_ptr->modelAdapter()->liveDelegatesChanged();
+}
+
+void ViewportSync::notifyUnloaded(StateTracker::ViewItem *item)
+{
+    m_lEvicted.remove(item);
+
+    if (!item->m_IsLive)
+        return;
+
+    if (item->m_pPreviousLive)
+        item->m_pPreviousLive->m_pNextLive = item->m_pNextLive;
+    else
+        m_pFirstLive = item->m_pNextLive;
+
+    if (item->m_pNextLive)
+        item->m_pNextLive->m_pPreviousLive = item->m_pPreviousLive;
+    else
+        m_pLastLive = item->m_pPreviousLive;
+
+    item->m_pPreviousLive = item->m_pNextLive = nullptr;
+    item->m_IsLive = false;
+    m_LiveCount--;
+
+    Q_EMIT q_ptr->modelAdapter()->liveDelegatesChanged();
+}
+
+void ViewportSync::touch(StateTracker::ViewItem *item)
+{
+    if ((!item->m_IsLive) || item == m_pLastLive)
+        return;
+
+    // Unlink
+    if (item->m_pPreviousLive)
+        item->m_pPreviousLive->m_pNextLive = item->m_pNextLive;
+    else
+        m_pFirstLive = item->m_pNextLive;
+
+    item->m_pNextLive->m_pPreviousLive = item->m_pPreviousLive;
+
+    // Append
+    item->m_pPreviousLive    = m_pLastLive;
+    item->m_pNextLive        = nullptr;
+    m_pLastLive->m_pNextLive = item;
+    m_pLastLive              = item;
+}
+
+void ViewportSync::enforceDelegateBudget()
+{
+    const int max = q_ptr->modelAdapter()->maxLiveDelegates();
+
+    if (max)
+        evictOffscreen(max);
+}
+
+void ViewportSync::evictOffscreen(int max)
+{
+    if (m_LiveCount <= max)
+        return;
+
+    const QRectF vp = q_ptr->currentRect();
+
+    auto i = m_pFirstLive;
+
+    while (i && m_LiveCount > max) {
+        auto next = i->m_pNextLive;
+        auto md   = i->m_pMetadata;
+
+        // The BUFFER items are loaded again when they enter the view
+        const bool canEvict = md && md->isValid() && (
+               i->state() == StateTracker::ViewItem::State::ACTIVE
+            || i->state() == StateTracker::ViewItem::State::BUFFER
+        );
+
+        // It will be loaded again when `restoreEvicted` finds it in view
+        if (canEvict && !md->decoratedGeometry().intersects(vp)) {
+            i->evict();
+            Q_ASSERT(!i->m_IsLive);
+            m_lEvicted << i;
+        }
+
+        i = next;
+    }
+}
+
+bool ViewportSync::deferLoading(StateTracker::ViewItem *item)
+{
+    // The geometry has to be known without the delegate
+    if (!(m_pGeoAdapter->capabilities() & GeometryAdapter::Capabilities::HAS_AHEAD_OF_TIME))
+        return false;
+
+    const auto md = item->m_pMetadata;
+
+    if ((!md) || md->decoratedGeometry().intersects(q_ptr->currentRect()))
+        return false;
+
+    // The buffered rows are created when the frame has time for them, the
+    // closest first. The UPDATE loads and attaches the delegate.
+    const auto s = q_ptr->modelAdapter()->view()->s_ptr->scheduler();
+
+    if (!s->budget())
+        return false;
+
+    s->schedule(md, IndexMetadata::ViewAction::UPDATE);
+
+    return true;
+}
+
+QPointF ViewportSync::originOf(IndexMetadata *md)
+{
+    const auto idx = md->index();
+
+    // Loaded from the start of the model
+    if ((!m_OriginIndex.isValid()) || idx.parent().isValid() || idx.row() <= 0) {
+        m_OriginIndex = QPersistentModelIndex();
+        m_Origin      = 0.0;
+        return {0.0, 0.0};
+    }
+
+    const auto m = idx.model();
+
+    // The rows above the far jump destination are loaded when scrolling back
+    for (int r = idx.row(); r < m_OriginIndex.row(); r++)
+        m_Origin -= m_pGeoAdapter->sizeHint(m->index(r, 0), nullptr).height();
+
+    for (int r = m_OriginIndex.row(); r < idx.row(); r++)
+        m_Origin += m_pGeoAdapter->sizeHint(m->index(r, 0), nullptr).height();
+
+    m_OriginIndex = idx;
+
+    return {0.0, m_Origin};
+}
+
+void ViewportSync::restoreEvicted()
+{
+    if (m_lEvicted.isEmpty())
+        return;
+
+    const QRectF vp = q_ptr->currentRect();
+
+    QVector<StateTracker::ViewItem*> restore;
+
+    for (auto i : qAsConst(m_lEvicted)) {
+        // An evicted item moved back to the buffer is loaded by the `move`
+        // which brings it into view again.
+        if (i->state() == StateTracker::ViewItem::State::ACTIVE
+          && i->m_pMetadata && i->m_pMetadata->decoratedGeometry().intersects(vp))
+            restore << i;
+    }
+
+    // Moving it loads the QQuickItem and places it. It is done outside of the
+    // loop since it can evict other delegates.
+    for (auto i : qAsConst(restore)) {
+        m_lEvicted.remove(i);
+        i->m_pMetadata << IndexMetadata::ViewAction::MOVE;
+    }
+}
+
+QQuickItem *ViewportSync::createDelegate(QQmlContext *pctx)
+{
+    const auto delegate = q_ptr->modelAdapter()->delegate();
+    if (!delegate) {
+        qWarning() << "No delegate is set";
+        return nullptr;
+    }
+
+    const qreal width = q_ptr->modelAdapter()->view()->width();
+
+    // Create a parent item to hold the delegate and all children
+    auto container = qobject_cast<QQuickItem *>(component()->create(pctx));
+    container->setWidth(width);
+    engine()->setObjectOwnership(container, QQmlEngine::CppOwnership);
+
+    // Create a context with all the tree roles
+    auto ctx = new QQmlContext(pctx);
+
+    // Create the delegate
+    auto item = qobject_cast<QQuickItem *>(delegate->create(ctx));
+    engine()->setObjectOwnership(item, QQmlEngine::CppOwnership);
+
+    // It allows the children to be added anyway
+    if(!item) {
+        if (!delegate->errorString().isEmpty())
+            qWarning() << delegate->errorString();
+
+        return container;
+    }
+
+    item->setWidth(width);
+    item->setParentItem(container);
+
+    // Resize the container
+    container->setHeight(item->height());
+
+    // Make sure it can be resized dynamically
+    QObject::connect(item, &QQuickItem::heightChanged, container, [container, item](){
+        container->setHeight(item->height());
+    });
 
-    m_pComponent = new QQmlComponent(m_pEngine);
-    m_pComponent->setData("import QtQuick 2.4; Item {property QtObject content: null;}", {});
+    container->setProperty("content", QVariant::fromValue(item));
 
-    return m_pComponent;
+    return container;
 }
 
 #include <viewport.moc>
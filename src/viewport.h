@@ -73,6 +73,9 @@ public:
 Q_SIGNALS:
     void contentChanged();
 
+    /// Only emitted when the width changes, the height doesn't affect sizes
+    void widthChanged(qreal width);
+
 public:
     ViewportPrivate *d_ptr;
 };
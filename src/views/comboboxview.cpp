@@ -21,6 +21,10 @@
 #include <QQmlEngine>
 #include <QQmlContext>
 #include <QQuickWindow>
+#include <QQmlComponent>
+
+// KQuickItemViews
+#include <private/componentcache_p.h>
 
 class ComboBoxViewPrivate final : public QObject
 {
@@ -91,10 +95,11 @@ void ComboBoxViewPrivate::slotWindowChanged(QQuickWindow *window)
 
         Q_ASSERT(engine);
 
-        QQmlComponent cbb(engine, q_ptr);
-        cbb.setData("import QtQuick 2.4; import QtQuick.Controls 2.0;"\
-        "ComboBox {textRole: \"display\"; anchors.fill: parent;}", {});
-        m_pItem = qobject_cast<QQuickItem*>(cbb.create());
+        auto cbb = ComponentCache::get(engine,
+            "import QtQuick 2.4; import QtQuick.Controls 2.0;"\
+            "ComboBox {textRole: \"display\"; anchors.fill: parent;}"
+        );
+        m_pItem = qobject_cast<QQuickItem*>(cbb->create());
 
         if (m_pSelectionModel)
             q_ptr->setSelectionModel(m_pSelectionModel);
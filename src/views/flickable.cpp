@@ -21,7 +21,9 @@
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QEasingCurve>
 #include <QtCore/QTimer>
-#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtQuick/QQuickWindow>
 #include <QQmlComponent>
 #include <QQmlEngine>
 #include <QQmlContext>
@@ -50,7 +52,7 @@ public:
         PRESS   , /*!< When a mouse button is pressed  */
         RELEASE , /*!< When a mouse button is released */
         MOVE    , /*!< When the mouse moves            */
-        TIMER   , /*!< 30 times per seconds            */
+        TIMER   , /*!< Once per rendered frame         */
         OTHER   , /*!< Doesn't affect the state        */
         ACCEPT  , /*!< Accept the drag ownership       */
         REJECT  , /*!< Reject the drag ownership       */
@@ -72,13 +74,35 @@ public:
     QQuickItem* m_pContainer {nullptr};
     QPointF     m_StartPoint {       };
     QPointF     m_DragPoint  {       };
-    QTimer*     m_pTimer     {nullptr};
-    qint64      m_StartTime  {   0   };
-    int         m_LastDelta  {   0   };
     qreal       m_Velocity   {   0   };
+    qreal       m_FlickEndY  {   0   };
     qreal       m_DecelRate  {  0.9  };
     bool        m_Interactive{ true  };
 
+    // Inertia is driven by the window frames, not by a timer
+    QPointer<QQuickWindow> m_pWindow;
+    QElapsedTimer          m_FrameTime;
+    bool                   m_IsFrameRequested {false};
+
+    /// The velocities are in points per frame at this reference frame rate
+    static constexpr const qreal REFERENCE_FRAME = 1000.0/30.0;
+
+    /// Only the most recent pointer movements define the flick velocity
+    static constexpr const int VELOCITY_WINDOW = 100;
+
+    /// All the samples use this monotonic clock, the event timestamps can be 0
+    QElapsedTimer m_SampleClock;
+
+    // The pointer positions, as a ring buffer
+    struct Sample {
+        qint64 time;
+        qreal  y;
+    };
+    static constexpr const int SAMPLE_COUNT = 16;
+    Sample m_lSamples[SAMPLE_COUNT];
+    int    m_SampleHead  {0};
+    int    m_SampleCount {0};
+
     mutable QQmlContext *m_pRootContext {nullptr};
 
     qreal m_MaxVelocity {std::numeric_limits<qreal>::max()};
@@ -88,7 +112,10 @@ public:
     // Helpers
     void loadVisibleElements();
     bool applyEvent(DragEvent event, QMouseEvent* e);
-    bool updateVelocity();
+    bool updateVelocity(qint64 now);
+    void addSample(QMouseEvent* e);
+    qreal boundedY(qreal y) const;
+    void requestFrame();
     DragEvent eventMapper(QEvent* e) const;
 
     // State machine
@@ -99,6 +126,7 @@ public:
 
 public Q_SLOTS:
     void tick();
+    void slotWindowChanged(QQuickWindow *w);
 };
 
 #define A &FlickablePrivate::           // Actions
@@ -131,9 +159,10 @@ Flickable::Flickable(QQuickItem* parent)
     setAcceptedMouseButtons(Qt::LeftButton);
     setFiltersChildMouseEvents(true);
 
-    d_ptr->m_pTimer = new QTimer(this);
-    d_ptr->m_pTimer->setInterval(1000/30);
-    connect(d_ptr->m_pTimer, &QTimer::timeout, d_ptr, &FlickablePrivate::tick);
+    d_ptr->m_SampleClock.start();
+
+    connect(this, &QQuickItem::windowChanged,
+        d_ptr, &FlickablePrivate::slotWindowChanged);
 }
 
 Flickable::~Flickable()
@@ -151,9 +180,8 @@ QQuickItem* Flickable::contentItem()
         // Can't be called too early as the engine wont be ready.
         Q_ASSERT(engine);
 
-        QQmlComponent rect1(engine, this);
-        rect1.setData("import QtQuick 2.4; Item {}", {});
-        d_ptr->m_pContainer = qobject_cast<QQuickItem *>(rect1.create());
+        // A plain item, there is no need to involve the QML compiler
+        d_ptr->m_pContainer = new QQuickItem();
         d_ptr->m_pContainer->setHeight(height());
         d_ptr->m_pContainer->setWidth(width ());
         engine->setObjectOwnership(d_ptr->m_pContainer, QQmlEngine::CppOwnership);
@@ -188,11 +216,7 @@ void Flickable::setCurrentY(qreal y)
     if (!d_ptr->m_pContainer)
         return;
 
-    // Do not allow out of bound scroll
-    y = std::fmax(y, 0);
-
-    if (d_ptr->m_pContainer->height() >= height())
-        y = std::fmin(y, d_ptr->m_pContainer->height() - height());
+    y = d_ptr->boundedY(y);
 
     if (d_ptr->m_pContainer->y() == -y)
         return;
@@ -214,10 +238,76 @@ qreal Flickable::contentHeight() const
     return  d_ptr->m_pContainer->height();
 }
 
-/// Timer events
+/// Frame events
 void FlickablePrivate::tick()
 {
+    // `afterAnimating` is emitted for every frame, including the other items
+    if (!m_IsFrameRequested)
+        return;
+
+    m_IsFrameRequested = false;
+
+    // The inertia may have been stopped since the frame was requested
+    if (m_State != DragState::INERTIA)
+        return;
+
     applyEvent(DragEvent::TIMER, nullptr);
+
+    if (m_State == DragState::INERTIA)
+        requestFrame();
+}
+
+void FlickablePrivate::requestFrame()
+{
+    if (m_IsFrameRequested)
+        return;
+
+    m_IsFrameRequested = true;
+
+    // Queued since it is called from `afterAnimating`, while the window is
+    // already in the middle of preparing a frame. Without a window, nothing
+    // is rendered anyway, so approximate the frame rate.
+    if (m_pWindow)
+        QMetaObject::invokeMethod(m_pWindow, "update", Qt::QueuedConnection);
+    else
+        QTimer::singleShot(int(REFERENCE_FRAME), this, &FlickablePrivate::tick);
+}
+
+void FlickablePrivate::slotWindowChanged(QQuickWindow *w)
+{
+    if (m_pWindow)
+        disconnect(m_pWindow, &QQuickWindow::afterAnimating,
+            this, &FlickablePrivate::tick);
+
+    // Emitted in the GUI thread before the scene graph synchronization
+    if ((m_pWindow = w))
+        connect(w, &QQuickWindow::afterAnimating,
+            this, &FlickablePrivate::tick);
+
+    m_IsFrameRequested = false;
+
+    if (m_State == DragState::INERTIA)
+        requestFrame();
+}
+
+/// Do not allow out of bound scroll
+qreal FlickablePrivate::boundedY(qreal y) const
+{
+    y = std::fmax(y, 0);
+
+    if (m_pContainer->height() >= q_ptr->height())
+        y = std::fmin(y, m_pContainer->height() - q_ptr->height());
+
+    return y;
+}
+
+void FlickablePrivate::addSample(QMouseEvent* e)
+{
+    m_lSamples[m_SampleHead] = {m_SampleClock.elapsed(), qreal(e->pos().y())};
+    m_SampleHead  = (m_SampleHead + 1) % SAMPLE_COUNT;
+
+    if (m_SampleCount < SAMPLE_COUNT)
+        m_SampleCount++;
 }
 
 /**
@@ -225,15 +315,39 @@ void FlickablePrivate::tick()
  * movements, but nevertheless the intention is to keep the inertia factor
  * from its vector.
  *
+ * The velocity is the least squares slope of the pointer positions during
+ * the last VELOCITY_WINDOW milliseconds. Slowly dragging then quickly
+ * flicking is then not averaged over the whole drag. Holding the pointer
+ * still before releasing it leaves no samples and no inertia.
+ *
  * @return If there is inertia
  */
-bool FlickablePrivate::updateVelocity()
+bool FlickablePrivate::updateVelocity(qint64 now)
 {
-    const qreal dy = m_DragPoint.y() - m_StartPoint.y();
-    const qreal dt = (QDateTime::currentMSecsSinceEpoch() - m_StartTime)/(1000.0/30.0);
+    qreal st = 0, sy = 0, stt = 0, sty = 0;
+    int n = 0;
+
+    for (int i = 0; i < m_SampleCount; i++) {
+        const auto &s = m_lSamples[(m_SampleHead - 1 - i + SAMPLE_COUNT) % SAMPLE_COUNT];
+
+        if (now - s.time > VELOCITY_WINDOW)
+            break;
+
+        // Relative to `now` to keep the sums small
+        const qreal t = s.time - now;
+
+        st  += t;
+        sy  += s.y;
+        stt += t*t;
+        sty += t*s.y;
+        n++;
+    }
+
+    const qreal denom = n*stt - st*st;
 
     // Points per frame
-    m_Velocity = (dy/dt);
+    m_Velocity = (n < 2 || qFuzzyIsNull(denom)) ?
+        0 : REFERENCE_FRAME * (n*sty - st*sy) / denom;
 
     // Do not start for low velocity mouse release
     if (std::fabs(m_Velocity) < 40) //TODO C++17 use std::clamp
@@ -368,8 +482,14 @@ bool FlickablePrivate::error(QMouseEvent*)
 
 bool FlickablePrivate::stop(QMouseEvent* event)
 {
-    m_pTimer->stop();
+    // The pending frame, if any, is ignored by `tick`
     m_Velocity = 0;
+
+    if (m_FlickEndY != q_ptr->currentY()) {
+        m_FlickEndY = q_ptr->currentY();
+        emit q_ptr->flickEndYChanged(m_FlickEndY);
+    }
+
     m_StartPoint = m_DragPoint  = {};
 
     // Resend for further processing
@@ -388,13 +508,7 @@ bool FlickablePrivate::drag(QMouseEvent* e)
     m_DragPoint = e->pos();
     q_ptr->setCurrentY(q_ptr->currentY() - dy);
 
-    // Reset the inertia on the differential inflexion points
-    if ((m_LastDelta >= 0) ^ (dy >= 0)) {
-        m_StartPoint = e->pos();
-        m_StartTime  = QDateTime::currentMSecsSinceEpoch();
-    }
-
-    m_LastDelta = dy;
+    addSample(e);
 
     return true;
 }
@@ -402,7 +516,8 @@ bool FlickablePrivate::drag(QMouseEvent* e)
 bool FlickablePrivate::start(QMouseEvent* e)
 {
     m_StartPoint = m_DragPoint = e->pos();
-    m_StartTime  = QDateTime::currentMSecsSinceEpoch();
+    m_SampleCount = 0;
+    addSample(e);
 
     q_ptr->setFocus(true, Qt::MouseFocusReason);
 
@@ -424,8 +539,17 @@ bool FlickablePrivate::release(QMouseEvent*)
     q_ptr->setKeepMouseGrab(false);
     q_ptr->ungrabMouse();
 
-    if (updateVelocity())
-        m_pTimer->start();
+    if (updateVelocity(m_SampleClock.elapsed())) {
+        // The integral of the velocity decay, see `inertia`
+        const qreal distance = (m_DecelRate > 0 && m_DecelRate < 1) ?
+            m_Velocity / -std::log(m_DecelRate) : 0;
+
+        m_FlickEndY = boundedY(q_ptr->currentY() - distance);
+        emit q_ptr->flickEndYChanged(m_FlickEndY);
+
+        m_FrameTime.start();
+        requestFrame();
+    }
     else
         applyEvent(DragEvent::TIMEOUT, nullptr);
 
@@ -464,9 +588,18 @@ bool FlickablePrivate::eval(QMouseEvent* e)
 
 bool FlickablePrivate::inertia(QMouseEvent*)
 {
-    m_Velocity *= m_DecelRate;
+    // Use the real frame duration, it varies with the display refresh rate
+    // and when frames are dropped. Long stalls are capped to avoid jumps.
+    const qreal frames = std::fmin(m_FrameTime.restart(), 100) / REFERENCE_FRAME;
+
+    const qreal v = m_Velocity;
+    m_Velocity *= std::pow(m_DecelRate, frames);
+
+    // The distance is the integral of the decay over the elapsed time
+    const qreal distance = (m_DecelRate > 0 && m_DecelRate < 1) ?
+        (v - m_Velocity) / -std::log(m_DecelRate) : v * frames;
 
-    q_ptr->setCurrentY(q_ptr->currentY() - m_Velocity);
+    q_ptr->setCurrentY(q_ptr->currentY() - distance);
 
     // Clamp the asymptotes to avoid an infinite loop, I chose a random value
     if (std::fabs(m_Velocity) < 0.05)
@@ -487,6 +620,11 @@ bool Flickable::isMoving() const
         || d_ptr->m_State == FlickablePrivate::DragState::INERTIA;
 }
 
+qreal Flickable::flickEndY() const
+{
+    return d_ptr->m_FlickEndY;
+}
+
 qreal Flickable::flickDeceleration() const
 {
     return d_ptr->m_DecelRate;
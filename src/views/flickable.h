@@ -59,6 +59,15 @@ public:
      */
     Q_PROPERTY(QRectF viewport READ viewport NOTIFY viewportChanged)
 
+    /**
+     * The contentY where the current (or last) flick will come to a stop.
+     *
+     * It is known as soon as the pointer is released, so the size hints of
+     * the rows up to it are measured before the inertia reaches them (for
+     * latency). Loading the delegates there is left to the inertia.
+     */
+    Q_PROPERTY(qreal flickEndY READ flickEndY NOTIFY flickEndYChanged)
+
     explicit Flickable(QQuickItem* parent = nullptr);
     virtual ~Flickable();
 
@@ -74,6 +83,8 @@ public:
     bool isDragging() const;
     bool isMoving() const;
 
+    qreal flickEndY() const;
+
     qreal flickDeceleration() const;
     void setFlickDeceleration(qreal v);
 
@@ -92,6 +103,7 @@ Q_SIGNALS:
     void draggingChanged(bool dragging);
     void movingChanged(bool dragging);
     void viewportChanged(const QRectF &view);
+    void flickEndYChanged(qreal y);
 
 protected:
     bool event(QEvent *ev) override;
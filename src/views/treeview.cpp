@@ -185,6 +185,16 @@ QVariant TreeContextProperties::getProperty(AbstractItemAdapter* item, uint id,
 
 void TreeContextProperties::setProperty(AbstractItemAdapter* item, uint id, const QVariant& value) const
 {
-    Q_ASSERT(id == 0 && item && value.canConvert<bool>());
-    item->setCollapsed(!value.toBool());
+    Q_ASSERT(item && value.canConvert<bool>());
+
+    switch(id) {
+        case 0 /*expanded*/:
+            item->setCollapsed(!value.toBool());
+
+            // The cached value is stored in the context
+            changeProperty(item, id);
+            break;
+        default:
+            Q_ASSERT(false);
+    }
 }
@@ -0,0 +1,121 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+
+// Qt
+#include <QtTest/QtTest>
+#include <QtGui/QStandardItemModel>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QQmlExpression>
+
+// KQuickItemViews
+#include <contextadapterfactory.h>
+#include <adapters/contextadapter.h>
+
+static constexpr const int COUNT_ROLE = Qt::UserRole;
+
+/**
+ * Check how the typed roles expose the empty values to QML.
+ */
+class ContextAdapterFactoryTest final : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testTypedEmpty();
+    void testInferredEmpty();
+
+private:
+    QQmlEngine            *m_pEngine  {nullptr};
+    QStandardItemModel    *m_pModel   {nullptr};
+    ContextAdapterFactory *m_pFactory {nullptr};
+
+    /// Evaluate `expr` in the context of `row`
+    QVariant evaluate(int row, const QString &expr);
+};
+
+void ContextAdapterFactoryTest::init()
+{
+    m_pEngine  = new QQmlEngine();
+    m_pModel   = new QStandardItemModel();
+    m_pFactory = new ContextAdapterFactory();
+
+    m_pModel->setItemRoleNames({
+        {Qt::DisplayRole, "display"},
+        {COUNT_ROLE     , "count"  },
+    });
+
+    // The count of the second row is empty
+    for (int i = 0; i < 3; i++) {
+        auto item = new QStandardItem(QStringLiteral("row%1").arg(i));
+
+        if (i != 1)
+            item->setData(i + 10, COUNT_ROLE);
+
+        m_pModel->appendRow(item);
+    }
+
+    m_pFactory->setModel(m_pModel);
+}
+
+void ContextAdapterFactoryTest::cleanup()
+{
+    delete m_pFactory;
+    delete m_pModel;
+    delete m_pEngine;
+}
+
+QVariant ContextAdapterFactoryTest::evaluate(int row, const QString &expr)
+{
+    auto adapter = m_pFactory->createAdapter(m_pEngine->rootContext());
+    adapter->setModelIndex(m_pModel->index(row, 0));
+
+    QQmlExpression e(adapter->context(), nullptr, expr);
+    const QVariant ret = e.evaluate();
+
+    delete adapter;
+
+    return ret;
+}
+
+void ContextAdapterFactoryTest::testTypedEmpty()
+{
+    m_pFactory->setRoleTypes({{"count", QMetaType::Int}});
+
+    QCOMPARE(evaluate(0, QStringLiteral("count")).toInt(), 10);
+
+    // A typed role can't be undefined, it gets the default value of the type
+    QCOMPARE(evaluate(1, QStringLiteral("count === undefined")).toBool(), false);
+    QCOMPARE(evaluate(1, QStringLiteral("count")).toInt(), 0);
+}
+
+void ContextAdapterFactoryTest::testInferredEmpty()
+{
+    // The empty row is sampled, so the role stays a QVariant
+    QCOMPARE(evaluate(0, QStringLiteral("count")).toInt(), 10);
+    QCOMPARE(evaluate(1, QStringLiteral("count === undefined")).toBool(), true);
+
+    // The display role is always a string
+    QCOMPARE(evaluate(1, QStringLiteral("display")).toString(), QStringLiteral("row1"));
+}
+
+QTEST_MAIN(ContextAdapterFactoryTest)
+
+#include "contextadapterfactorytest.moc"
@@ -0,0 +1,182 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+
+// Qt
+#include <QtTest/QtTest>
+#include <QtCore/QStringListModel>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QQmlComponent>
+#include <QQuickWindow>
+#include <QQuickItem>
+
+// LibStdC++
+#include <cmath>
+
+// KQuickItemViews
+#include <views/listview.h>
+#include <adapters/modeladapter.h>
+
+/**
+ * Check that the live delegate budget frees the offscreen delegates and that
+ * they are created again once scrolled back into view.
+ */
+class EvictionTest final : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testBudgetRespected();
+    void testRestoredWhenVisible();
+
+private:
+    static constexpr const int BUDGET = 30;
+
+    QQmlEngine       *m_pEngine {nullptr};
+    QQuickWindow     *m_pWindow {nullptr};
+    QStringListModel *m_pModel  {nullptr};
+    ListView         *m_pView   {nullptr};
+
+    ModelAdapter *adapter() const;
+
+    /// Scroll in steps, like the user would, so each page gets loaded
+    void scrollTo(qreal y);
+
+    /// The visible delegate showing `text`, if it is loaded
+    static QQuickItem *find(QQuickItem *root, const QString &text);
+};
+
+void EvictionTest::initTestCase()
+{
+    qmlRegisterType<ListView>("KQuickItemViewsTest", 1, 0, "QuickListView");
+}
+
+void EvictionTest::init()
+{
+    QStringList rows;
+
+    for (int i = 0; i < 1000; i++)
+        rows << QStringLiteral("row%1").arg(i);
+
+    m_pModel  = new QStringListModel(rows);
+    m_pEngine = new QQmlEngine();
+    m_pWindow = new QQuickWindow();
+    m_pWindow->resize(200, 200);
+
+    m_pEngine->rootContext()->setContextProperty(QStringLiteral("rowModel"), m_pModel);
+
+    QQmlComponent c(m_pEngine);
+    c.setData(
+        "import QtQuick 2.7\n"
+        "import KQuickItemViewsTest 1.0\n"
+        "QuickListView {\n"
+        "    width: 200\n"
+        "    height: 200\n"
+        "    model: rowModel\n"
+        "    delegate: Rectangle {\n"
+        "        objectName: display\n"
+        "        width: 200\n"
+        "        height: 20\n"
+        "    }\n"
+        "}\n",
+        QUrl()
+    );
+
+    m_pView = qobject_cast<ListView*>(c.create());
+    QVERIFY2(m_pView, qPrintable(c.errorString()));
+
+    // The model is only loaded in the next event loop iteration
+    adapter()->setMaxLiveDelegates(BUDGET);
+    m_pView->setParentItem(m_pWindow->contentItem());
+
+    m_pWindow->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_pWindow));
+
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row0")));
+}
+
+void EvictionTest::cleanup()
+{
+    delete m_pView;
+    delete m_pWindow;
+    delete m_pEngine;
+    delete m_pModel;
+}
+
+ModelAdapter *EvictionTest::adapter() const
+{
+    return m_pView->modelAdapters().first();
+}
+
+void EvictionTest::scrollTo(qreal y)
+{
+    const qreal step = y > m_pView->currentY() ? 100 : -100;
+
+    while (std::fabs(m_pView->currentY() - y) > std::fabs(step)) {
+        m_pView->setCurrentY(m_pView->currentY() + step);
+        QTest::qWait(20);
+    }
+
+    m_pView->setCurrentY(y);
+    QTest::qWait(20);
+}
+
+QQuickItem *EvictionTest::find(QQuickItem *root, const QString &text)
+{
+    for (auto child : root->childItems()) {
+        if (child->objectName() == text && child->isVisible())
+            return child;
+
+        if (auto ret = find(child, text))
+            return ret;
+    }
+
+    return nullptr;
+}
+
+void EvictionTest::testBudgetRespected()
+{
+    scrollTo(5000);
+
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row250")));
+    QTRY_VERIFY(adapter()->liveDelegates() <= BUDGET);
+
+    // The first page is long gone
+    QTRY_VERIFY(!find(m_pView, QStringLiteral("row0")));
+}
+
+void EvictionTest::testRestoredWhenVisible()
+{
+    scrollTo(5000);
+    QTRY_VERIFY(!find(m_pView, QStringLiteral("row0")));
+
+    scrollTo(0);
+
+    // The evicted delegates are created again, not left empty
+    for (int i = 0; i < 10; i++)
+        QTRY_VERIFY(find(m_pView, QStringLiteral("row%1").arg(i)));
+
+    QVERIFY(adapter()->liveDelegates() <= BUDGET);
+}
+
+QTEST_MAIN(EvictionTest)
+
+#include "evictiontest.moc"
@@ -0,0 +1,193 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+
+// Qt
+#include <QtTest/QtTest>
+#include <QtCore/QStringListModel>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QQmlComponent>
+#include <QQuickWindow>
+#include <QQuickItem>
+
+// KQuickItemViews
+#include <viewport.h>
+#include <views/listview.h>
+#include <adapters/modeladapter.h>
+#include <proxies/sizehintproxymodel.h>
+#include <private/viewport_p.h>
+
+/**
+ * Check that jumping far away only loads the rows at the destination, the
+ * rows on the way are skipped using the size hints.
+ */
+class FarJumpTest final : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testSkipped();
+    void testPosition();
+    void testJumpBack();
+
+private:
+    QQmlEngine         *m_pEngine {nullptr};
+    QQuickWindow       *m_pWindow {nullptr};
+    QStringListModel   *m_pModel  {nullptr};
+    SizeHintProxyModel *m_pProxy  {nullptr};
+    ListView           *m_pView   {nullptr};
+
+    /// If the row has a metadata, loaded or not
+    bool isTracked(int row) const;
+
+    /// The visible delegate showing `text`, if it is loaded
+    static QQuickItem *find(QQuickItem *root, const QString &text);
+};
+
+void FarJumpTest::initTestCase()
+{
+    qmlRegisterType<ListView>("KQuickItemViewsTest", 1, 0, "QuickListView");
+}
+
+void FarJumpTest::init()
+{
+    QStringList rows;
+
+    for (int i = 0; i < 10000; i++)
+        rows << QStringLiteral("row%1").arg(i);
+
+    m_pModel  = new QStringListModel(rows);
+    m_pEngine = new QQmlEngine();
+    m_pProxy  = new SizeHintProxyModel();
+    m_pWindow = new QQuickWindow();
+    m_pWindow->resize(200, 200);
+
+    // The proxy provides the geometry before the delegates are created
+    QQmlEngine::setContextForObject(m_pProxy, m_pEngine->rootContext());
+    m_pProxy->setSizeHintFunctor([](const QModelIndex &) {
+        return QSizeF {200, 20};
+    });
+    m_pProxy->setSourceModel(m_pModel);
+
+    m_pEngine->rootContext()->setContextProperty(QStringLiteral("rowModel"), m_pProxy);
+
+    QQmlComponent c(m_pEngine);
+    c.setData(
+        "import QtQuick 2.7\n"
+        "import KQuickItemViewsTest 1.0\n"
+        "QuickListView {\n"
+        "    width: 200\n"
+        "    height: 200\n"
+        "    model: rowModel\n"
+        "    delegate: Rectangle {\n"
+        "        objectName: display\n"
+        "        width: 200\n"
+        "        height: 20\n"
+        "    }\n"
+        "}\n",
+        QUrl()
+    );
+
+    m_pView = qobject_cast<ListView*>(c.create());
+    QVERIFY2(m_pView, qPrintable(c.errorString()));
+
+    m_pView->setParentItem(m_pWindow->contentItem());
+
+    m_pWindow->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_pWindow));
+
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row0")));
+}
+
+void FarJumpTest::cleanup()
+{
+    delete m_pView;
+    delete m_pWindow;
+    delete m_pProxy;
+    delete m_pEngine;
+    delete m_pModel;
+}
+
+bool FarJumpTest::isTracked(int row) const
+{
+    const auto vp = m_pView->modelAdapters().first()->viewports().first();
+
+    return vp->s_ptr->metadataForIndex(m_pProxy->index(row, 0)) != nullptr;
+}
+
+QQuickItem *FarJumpTest::find(QQuickItem *root, const QString &text)
+{
+    for (auto child : root->childItems()) {
+        if (child->objectName() == text && child->isVisible())
+            return child;
+
+        if (auto ret = find(child, text))
+            return ret;
+    }
+
+    return nullptr;
+}
+
+void FarJumpTest::testSkipped()
+{
+    m_pView->setCurrentY(100000);
+
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row5000")));
+
+    // Neither the first page nor the rows on the way are tracked anymore
+    QVERIFY(!isTracked(0));
+    QVERIFY(!isTracked(2500));
+    QVERIFY(isTracked(5000));
+
+    QVERIFY(m_pView->modelAdapters().first()->liveDelegates() < 100);
+}
+
+void FarJumpTest::testPosition()
+{
+    m_pView->setCurrentY(100000);
+
+    QQuickItem *item = nullptr;
+    QTRY_VERIFY((item = find(m_pView, QStringLiteral("row5000"))));
+
+    // The position is the sum of the size hints above it
+    const QPointF pos = item->mapToItem(m_pView->contentItem(), {0, 0});
+    QCOMPARE(pos.y(), 100000.0);
+}
+
+void FarJumpTest::testJumpBack()
+{
+    m_pView->setCurrentY(100000);
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row5000")));
+
+    // Scroll a bit up, the rows above the destination are loaded one by one
+    m_pView->setCurrentY(99900);
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row4995")));
+    QVERIFY(!isTracked(2500));
+
+    m_pView->setCurrentY(0);
+
+    QTRY_VERIFY(find(m_pView, QStringLiteral("row0")));
+    QVERIFY(!isTracked(5000));
+}
+
+QTEST_MAIN(FarJumpTest)
+
+#include "farjumptest.moc"
@@ -0,0 +1,300 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+
+// Qt
+#include <QtTest/QtTest>
+#include <QtCore/QStringListModel>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QQmlComponent>
+#include <QQuickWindow>
+
+// LibStdC++
+#include <algorithm>
+
+// KQuickItemViews
+#include <viewbase.h>
+#include <views/listview.h>
+#include <adapters/modeladapter.h>
+#include <proxies/sizehintproxymodel.h>
+#include <private/viewbase_p.h>
+#include <private/framescheduler_p.h>
+
+/// Keep the order in which the delegates are created
+class CreationRecorder final : public QObject
+{
+    Q_OBJECT
+public:
+    Q_INVOKABLE void add(const QString &text) { m_lRows << text.mid(3).toInt(); }
+
+    QVector<int> m_lRows;
+};
+
+/**
+ * Check the order in which the FrameScheduler runs the deferred callbacks.
+ *
+ * The view has no window, so the frames are emulated by the event loop. The
+ * last tests use a real ListView to check the offscreen delegates.
+ */
+class FrameSchedulerTest final : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testDefaultBudget();
+    void testDeferred();
+    void testPhases();
+    void testReplaced();
+    void testDestroyedKey();
+    void testCancelOnce();
+    void testRescheduled();
+    void testClosestFirst();
+    void testBudgetCutOff();
+
+private:
+    ViewBase       *m_pView      {nullptr};
+    FrameScheduler *m_pScheduler {nullptr};
+    QStringList     m_lCalls;
+
+    QQmlEngine         *m_pEngine   {nullptr};
+    QQuickWindow       *m_pWindow   {nullptr};
+    QStringListModel   *m_pModel    {nullptr};
+    SizeHintProxyModel *m_pProxy    {nullptr};
+    ListView           *m_pList     {nullptr};
+    CreationRecorder   *m_pRecorder {nullptr};
+
+    /// A list with a known geometry and slow delegates, to fill the frames
+    void createList(int budget);
+};
+
+void FrameSchedulerTest::init()
+{
+    m_pView      = new ViewBase();
+    m_pScheduler = new FrameScheduler(m_pView);
+    m_lCalls.clear();
+}
+
+void FrameSchedulerTest::cleanup()
+{
+    delete m_pView;
+    delete m_pList;
+    delete m_pWindow;
+    delete m_pProxy;
+    delete m_pEngine;
+    delete m_pModel;
+    delete m_pRecorder;
+
+    m_pList     = nullptr;
+    m_pWindow   = nullptr;
+    m_pProxy    = nullptr;
+    m_pEngine   = nullptr;
+    m_pModel    = nullptr;
+    m_pRecorder = nullptr;
+}
+
+void FrameSchedulerTest::createList(int budget)
+{
+    QStringList rows;
+
+    for (int i = 0; i < 200; i++)
+        rows << QStringLiteral("row%1").arg(i);
+
+    m_pModel    = new QStringListModel(rows);
+    m_pEngine   = new QQmlEngine();
+    m_pProxy    = new SizeHintProxyModel();
+    m_pRecorder = new CreationRecorder();
+    m_pWindow   = new QQuickWindow();
+    m_pWindow->resize(200, 200);
+
+    // The proxy provides the geometry before the delegates are created
+    QQmlEngine::setContextForObject(m_pProxy, m_pEngine->rootContext());
+    m_pProxy->setSizeHintFunctor([](const QModelIndex &) {
+        return QSizeF {200, 20};
+    });
+    m_pProxy->setSourceModel(m_pModel);
+
+    m_pEngine->rootContext()->setContextProperty(QStringLiteral("rowModel"), m_pProxy);
+    m_pEngine->rootContext()->setContextProperty(QStringLiteral("recorder"), m_pRecorder);
+
+    QQmlComponent c(m_pEngine);
+    c.setData(
+        "import QtQuick 2.7\n"
+        "import KQuickItemViewsTest 1.0\n"
+        "QuickListView {\n"
+        "    width: 200\n"
+        "    height: 200\n"
+        "    model: rowModel\n"
+        "    delegate: Rectangle {\n"
+        "        width: 200\n"
+        "        height: 20\n"
+        "        Component.onCompleted: {\n"
+        "            recorder.add(display)\n"
+        "            var t = Date.now()\n"
+        "            while (Date.now() - t < 2);\n"
+        "        }\n"
+        "    }\n"
+        "}\n",
+        QUrl()
+    );
+
+    m_pList = qobject_cast<ListView*>(c.create());
+    QVERIFY2(m_pList, qPrintable(c.errorString()));
+
+    // The model is only loaded in the next event loop iteration
+    m_pList->setFrameBudget(budget);
+    m_pList->modelAdapters().first()->setCacheBuffer(50);
+    m_pList->setParentItem(m_pWindow->contentItem());
+}
+
+void FrameSchedulerTest::testDefaultBudget()
+{
+    QCOMPARE(m_pScheduler->budget(), 5);
+    QCOMPARE(m_pView->frameBudget(), 5);
+}
+
+void FrameSchedulerTest::testDeferred()
+{
+    QObject key;
+    m_pScheduler->scheduleOnce(&key, [this]() { m_lCalls << "a"; });
+
+    // Even with a budget of 0, it waits for the next frame
+    QVERIFY(m_lCalls.isEmpty());
+
+    QTRY_COMPARE(m_lCalls, QStringList {"a"});
+}
+
+void FrameSchedulerTest::testPhases()
+{
+    QObject k1, k2, k3;
+
+    m_pScheduler->scheduleOnce(&k1, [this]() { m_lCalls << "after";   },
+        FrameScheduler::Phase::AFTER_ACTIONS);
+    m_pScheduler->scheduleOnce(&k2, [this]() { m_lCalls << "before1"; });
+    m_pScheduler->scheduleOnce(&k3, [this]() { m_lCalls << "before2"; });
+
+    m_pScheduler->flush();
+
+    // The phase first, then the scheduling order
+    QCOMPARE(m_lCalls, (QStringList {"before1", "before2", "after"}));
+}
+
+void FrameSchedulerTest::testReplaced()
+{
+    QObject key;
+
+    for (int i = 0; i < 5; i++)
+        m_pScheduler->scheduleOnce(&key, [this, i]() { m_lCalls << QString::number(i); });
+
+    m_pScheduler->flush();
+
+    // A burst only runs the latest callback, once
+    QCOMPARE(m_lCalls, QStringList {"4"});
+
+    m_pScheduler->flush();
+    QCOMPARE(m_lCalls, QStringList {"4"});
+}
+
+void FrameSchedulerTest::testDestroyedKey()
+{
+    auto key = new QObject();
+    m_pScheduler->scheduleOnce(key, [this]() { m_lCalls << "a"; });
+    delete key;
+
+    m_pScheduler->flush();
+    QVERIFY(m_lCalls.isEmpty());
+}
+
+void FrameSchedulerTest::testCancelOnce()
+{
+    QObject k1, k2;
+
+    m_pScheduler->scheduleOnce(&k1, [this]() { m_lCalls << "a"; });
+    m_pScheduler->scheduleOnce(&k1, [this]() { m_lCalls << "b"; },
+        FrameScheduler::Phase::AFTER_ACTIONS);
+    m_pScheduler->scheduleOnce(&k2, [this]() { m_lCalls << "c"; });
+
+    m_pScheduler->cancelOnce(&k1);
+    m_pScheduler->flush();
+
+    QCOMPARE(m_lCalls, QStringList {"c"});
+}
+
+void FrameSchedulerTest::testRescheduled()
+{
+    QObject key;
+
+    // A callback scheduling itself again runs in the next frame, not now
+    m_pScheduler->scheduleOnce(&key, [this, &key]() {
+        m_lCalls << "first";
+        m_pScheduler->scheduleOnce(&key, [this]() { m_lCalls << "second"; });
+    });
+
+    m_pScheduler->flush();
+    QCOMPARE(m_lCalls, QStringList {"first"});
+
+    QTRY_COMPARE(m_lCalls, (QStringList {"first", "second"}));
+}
+
+void FrameSchedulerTest::testClosestFirst()
+{
+    qmlRegisterType<ListView>("KQuickItemViewsTest", 1, 0, "QuickListView");
+    createList(5);
+
+    m_pWindow->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_pWindow));
+
+    // The visible rows, then the buffer below it
+    QTRY_VERIFY(m_pRecorder->m_lRows.size() >= 50);
+
+    const auto s = m_pList->s_ptr->scheduler();
+    QTRY_COMPARE(s->pendingCount(), 0);
+
+    const auto &rows = m_pRecorder->m_lRows;
+
+    // The further a row is from the viewport, the later it is created
+    QVERIFY(std::is_sorted(rows.constBegin(), rows.constEnd()));
+}
+
+void FrameSchedulerTest::testBudgetCutOff()
+{
+    qmlRegisterType<ListView>("KQuickItemViewsTest", 1, 0, "QuickListView");
+    createList(5);
+
+    const auto s = m_pList->s_ptr->scheduler();
+
+    // Sample the progress at the end of each frame
+    bool partial = false;
+    QObject::connect(m_pWindow, &QQuickWindow::afterAnimating, m_pRecorder, [&]() {
+        partial |= s->pendingCount() && !m_pRecorder->m_lRows.isEmpty();
+    }, Qt::DirectConnection);
+
+    m_pWindow->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_pWindow));
+
+    QTRY_VERIFY(m_pRecorder->m_lRows.size() >= 50);
+    QTRY_COMPARE(s->pendingCount(), 0);
+
+    // Each delegate takes 2ms, the buffer can't fit in a single 5ms frame
+    QVERIFY(partial);
+}
+
+QTEST_MAIN(FrameSchedulerTest)
+
+#include "frameschedulertest.moc"
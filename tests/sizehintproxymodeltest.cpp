@@ -0,0 +1,245 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Emmanuel Lepage Vallee                          *
+ *   Author : Emmanuel Lepage Vallee <emmanuel.lepage@kde.org>             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ **************************************************************************/
+
+// Qt
+#include <QtTest/QtTest>
+#include <QtGui/QStandardItemModel>
+#include <QQmlEngine>
+
+// KQuickItemViews
+#include <proxies/sizehintproxymodel.h>
+
+/**
+ * Check when the SizeHintProxyModel cache computes the sizes again.
+ *
+ * The functor counts the calls, a cache hit doesn't call it.
+ */
+class SizeHintProxyModelTest final : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testCached();
+    void testInsertShifts();
+    void testRemoveShifts();
+    void testRemoveChildren();
+    void testInsertAboveParent();
+    void testInvalidationRole();
+    void testWidthBucket();
+    void testTextWrapsAtViewWidth();
+
+private:
+    QQmlEngine         *m_pEngine {nullptr};
+    QStandardItemModel *m_pModel  {nullptr};
+    SizeHintProxyModel *m_pProxy  {nullptr};
+    int                 m_Calls   {   0   };
+
+    /// The text length as height, to notice when the display role changes
+    QSizeF measure(const QModelIndex &idx);
+};
+
+QSizeF SizeHintProxyModelTest::measure(const QModelIndex &idx)
+{
+    m_Calls++;
+    return {100, qreal(idx.data().toString().size())};
+}
+
+void SizeHintProxyModelTest::init()
+{
+    m_pEngine = new QQmlEngine();
+    m_pModel  = new QStandardItemModel();
+    m_pProxy  = new SizeHintProxyModel();
+    m_Calls   = 0;
+
+    for (int i = 0; i < 10; i++)
+        m_pModel->appendRow(new QStandardItem(QString(i + 1, 'x')));
+
+    // The proxy evaluates its expressions in its QML context
+    QQmlEngine::setContextForObject(m_pProxy, m_pEngine->rootContext());
+
+    m_pProxy->setSizeHintFunctor([this](const QModelIndex &idx) {
+        return measure(idx);
+    });
+    m_pProxy->setSourceModel(m_pModel);
+}
+
+void SizeHintProxyModelTest::cleanup()
+{
+    delete m_pProxy;
+    delete m_pModel;
+    delete m_pEngine;
+}
+
+void SizeHintProxyModelTest::testCached()
+{
+    const auto idx = m_pProxy->index(3, 0);
+
+    QCOMPARE(m_pProxy->sizeHintForIndex(idx), QSizeF(100, 4));
+    QCOMPARE(m_pProxy->sizeHintForIndex(idx), QSizeF(100, 4));
+    QCOMPARE(m_Calls, 1);
+}
+
+void SizeHintProxyModelTest::testInsertShifts()
+{
+    m_pProxy->sizeHintForIndex(m_pProxy->index(3, 0));
+    m_pProxy->sizeHintForIndex(m_pProxy->index(4, 0));
+
+    m_pModel->insertRow(4, new QStandardItem(QStringLiteral("new")));
+
+    // The rows before and after the insertion are still cached
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(3, 0)), QSizeF(100, 4));
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(5, 0)), QSizeF(100, 5));
+    QCOMPARE(m_Calls, 2);
+
+    // The new row is measured
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(4, 0)), QSizeF(100, 3));
+    QCOMPARE(m_Calls, 3);
+}
+
+void SizeHintProxyModelTest::testRemoveShifts()
+{
+    m_pProxy->sizeHintForIndex(m_pProxy->index(2, 0));
+    m_pProxy->sizeHintForIndex(m_pProxy->index(3, 0));
+    m_pProxy->sizeHintForIndex(m_pProxy->index(6, 0));
+
+    m_pModel->removeRows(3, 2);
+
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(2, 0)), QSizeF(100, 3));
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(4, 0)), QSizeF(100, 7));
+    QCOMPARE(m_Calls, 3);
+
+    // It used to be row 5, which was never measured
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(3, 0)), QSizeF(100, 6));
+    QCOMPARE(m_Calls, 4);
+}
+
+void SizeHintProxyModelTest::testRemoveChildren()
+{
+    auto parent = m_pModel->item(1);
+    parent->appendRow(new QStandardItem(QStringLiteral("child")));
+
+    const auto pidx = m_pProxy->index(1, 0);
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0, pidx)), QSizeF(100, 5));
+
+    m_pModel->removeRow(1);
+
+    // A new parent at the same place must not reuse the old child size
+    auto other = new QStandardItem(QStringLiteral("other"));
+    other->appendRow(new QStandardItem(QStringLiteral("a")));
+    m_pModel->insertRow(1, other);
+
+    const auto nidx = m_pProxy->index(1, 0);
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0, nidx)), QSizeF(100, 1));
+    QCOMPARE(m_Calls, 2);
+}
+
+void SizeHintProxyModelTest::testInsertAboveParent()
+{
+    auto parent = m_pModel->item(5);
+    parent->appendRow(new QStandardItem(QStringLiteral("child")));
+
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0, m_pProxy->index(5, 0))), QSizeF(100, 5));
+
+    m_pModel->insertRows(0, 2);
+
+    // The parent moved to row 7, its children are still cached
+    const auto pidx = m_pProxy->index(7, 0);
+    QCOMPARE(pidx.data().toString(), QString(6, 'x'));
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0, pidx)), QSizeF(100, 5));
+    QCOMPARE(m_Calls, 1);
+
+    // Nothing is left at the old place
+    parent = m_pModel->item(5);
+    parent->appendRow(new QStandardItem(QStringLiteral("a")));
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0, m_pProxy->index(5, 0))), QSizeF(100, 1));
+    QCOMPARE(m_Calls, 2);
+}
+
+void SizeHintProxyModelTest::testInvalidationRole()
+{
+    m_pProxy->setInvalidationRoles({QStringLiteral("display")});
+
+    const auto idx = m_pProxy->index(3, 0);
+    m_pProxy->sizeHintForIndex(idx);
+
+    QSignalSpy spy(m_pProxy, &SizeHintProxyModel::sizeHintChanged);
+
+    // Same length, no change
+    m_pModel->item(3)->setText(QStringLiteral("yyyy"));
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(m_Calls, 2);
+
+    m_pModel->item(3)->setText(QStringLiteral("y"));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().first().value<QModelIndex>(), idx);
+    QCOMPARE(m_pProxy->sizeHintForIndex(idx), QSizeF(100, 1));
+    QCOMPARE(m_Calls, 3);
+
+    // Never measured, nothing to notify
+    m_pModel->item(7)->setText(QStringLiteral("z"));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(m_Calls, 3);
+}
+
+void SizeHintProxyModelTest::testWidthBucket()
+{
+    m_pProxy->setWidthBucketSize(100);
+    m_pProxy->setViewWidth(120);
+
+    const auto idx = m_pProxy->index(0, 0);
+    m_pProxy->sizeHintForIndex(idx);
+
+    // Same bucket
+    m_pProxy->setViewWidth(180);
+    m_pProxy->sizeHintForIndex(idx);
+    QCOMPARE(m_Calls, 1);
+
+    m_pProxy->setViewWidth(220);
+    QCOMPARE(m_pProxy->widthBucket(), 2);
+    m_pProxy->sizeHintForIndex(idx);
+    QCOMPARE(m_Calls, 2);
+}
+
+void SizeHintProxyModelTest::testTextWrapsAtViewWidth()
+{
+    const QString text = QStringLiteral("word ").repeated(20);
+    m_pModel->item(0)->setText(text);
+    m_pModel->item(1)->setText(QStringLiteral("word"));
+
+    m_pProxy->setSizeHintFunctor({});
+    m_pProxy->setTextRole(QStringLiteral("display"));
+    m_pProxy->setViewWidth(60);
+
+    const QSizeF line    = m_pProxy->sizeHintForIndex(m_pProxy->index(1, 0));
+    const QSizeF wrapped = m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0));
+
+    // Without a textWidth, the text wraps at the view width
+    QVERIFY(line.height() > 0);
+    QVERIFY(wrapped.height() >= 2 * line.height());
+    QVERIFY(wrapped.width() <= 60);
+
+    // An explicit textWidth has priority
+    m_pProxy->setTextWidth(10000);
+    QCOMPARE(m_pProxy->sizeHintForIndex(m_pProxy->index(0, 0)).height(), line.height());
+}
+
+QTEST_MAIN(SizeHintProxyModelTest)
+
+#include "sizehintproxymodeltest.moc"